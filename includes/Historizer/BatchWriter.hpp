@@ -0,0 +1,142 @@
+#ifndef __OPEN62541_BATCH_WRITER_HPP
+#define __OPEN62541_BATCH_WRITER_HPP
+
+#include "ConnectionPool.hpp"
+#include "HistorizerConfig.hpp"
+#include "HistorizerUtils.hpp"
+#include "PartitionManager.hpp"
+
+#include <HaSLL/Logger.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <open62541/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace open62541 {
+struct WriterMetrics {
+  size_t queue_depth = 0;
+  uint64_t written = 0;
+  uint64_t dropped = 0;
+  uint64_t spilled = 0;
+  uint64_t failed = 0;
+  std::chrono::microseconds last_flush_latency{0};
+  std::chrono::microseconds max_flush_latency{0};
+};
+
+/**
+ * @brief Resolves the sanitized node id of a historized node into the table,
+ * that its values are written into
+ *
+ */
+using StorageResolver = std::function<NodeStorage(const std::string&)>;
+
+/**
+ * @brief Decouples historization from the open62541 server thread
+ *
+ * Producers push copies of the received values into a bounded lock-free
+ * queue. A background thread drains the queue into per node batches and
+ * streams the batches of each table into the database with COPY, once the
+ * batch size is reached or the flush interval elapsed. Missing partitions of
+ * the shared tables are created before the batch is written.
+ *
+ */
+struct BatchWriter {
+  /**
+   * @param pool
+   * @param config
+   * @param resolver - called from the writer thread for every node in a batch
+   * @param partitions - nullptr, if the TablePerNode layout is used
+   */
+  BatchWriter(ConnectionPool* pool, const WriterConfig& config,
+      StorageResolver resolver, PartitionManager* partitions = nullptr);
+
+  ~BatchWriter();
+
+  /**
+   * @brief Queue a deep copy of the given value for historization
+   *
+   * @attention Depending on the configured OverflowPolicy, this call may
+   * block the caller while the queue is full
+   *
+   * @param node_id
+   * @param value
+   */
+  void push(const UA_NodeId* node_id, const UA_DataValue* value);
+
+  WriterMetrics metrics() const;
+
+private:
+  struct Sample {
+    UA_NodeId node_id;
+    UA_DataValue value;
+  };
+
+  using SampleQueue =
+      boost::lockfree::queue<Sample, boost::lockfree::fixed_sized<true>>;
+  using Batches = std::unordered_map<std::string, std::vector<Sample>>;
+
+  static void release(Sample* sample);
+
+  bool tryPush(const Sample& sample);
+
+  void overflow(Sample sample);
+
+  void spill(const std::vector<const Sample*>& samples);
+
+  /**
+   * @return false if a batch could not be written, since the database can
+   * not be reached, the rest of the spilled values are replayed later
+   */
+  bool replaySpill(Batches* batches, size_t* pending);
+
+  void run();
+
+  size_t drain(Batches* batches, size_t limit);
+
+  void add(Batches* batches, const Sample& sample);
+
+  /**
+   * @return false if the database could not be reached
+   */
+  bool flush(Batches* batches);
+
+  void recordFlushLatency(std::chrono::microseconds latency);
+
+  WriterConfig config_;
+  ConnectionPool* pool_;
+  StorageResolver resolver_;
+  PartitionManager* partitions_;
+  HaSLL::LoggerPtr logger_;
+  SampleQueue queue_;
+  std::atomic<size_t> depth_ = 0;
+  std::atomic<uint64_t> written_ = 0;
+  std::atomic<uint64_t> dropped_ = 0;
+  std::atomic<uint64_t> spilled_ = 0;
+  std::atomic<uint64_t> failed_ = 0;
+  std::atomic<int64_t> last_flush_latency_ = 0;
+  std::atomic<int64_t> max_flush_latency_ = 0;
+  std::atomic<bool> running_ = true;
+  std::atomic<bool> has_spill_ = false;
+  std::mutex spill_mx_;
+  std::ofstream spill_stream_;
+  // read position of a stopped replay, only used by the writer thread
+  std::streampos replay_offset_ = 0;
+  std::mutex wake_mx_;
+  std::condition_variable wake_;
+  std::condition_variable space_;
+  std::thread thread_;
+};
+
+using BatchWriterPtr = std::unique_ptr<BatchWriter>;
+} // namespace open62541
+#endif //__OPEN62541_BATCH_WRITER_HPP
@@ -0,0 +1,195 @@
+#ifndef __OPEN62541_CONNECTION_POOL_HPP
+#define __OPEN62541_CONNECTION_POOL_HPP
+
+#include "HistorizerConfig.hpp"
+
+#include <HaSLL/Logger.hpp>
+#include <pqxx/pqxx>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace open62541 {
+struct ConnectionPoolExhausted : std::runtime_error {
+  ConnectionPoolExhausted()
+      : std::runtime_error(
+            "No database connection became available within acquire timeout") {
+  }
+};
+
+struct ConnectionPool;
+
+using PreparedNames = std::unordered_set<std::string>;
+
+/**
+ * @brief RAII handle for a connection borrowed from the ConnectionPool. The
+ * connection is handed back to the pool when the handle is destroyed
+ *
+ */
+struct PooledConnection {
+  PooledConnection(const PooledConnection&) = delete;
+
+  PooledConnection(PooledConnection&& other) noexcept;
+
+  ~PooledConnection();
+
+  PooledConnection& operator=(const PooledConnection&) = delete;
+
+  PooledConnection& operator=(PooledConnection&&) = delete;
+
+  pqxx::connection& operator*() const;
+
+  pqxx::connection* operator->() const;
+
+  /**
+   * @brief Get a statement, that was registered with the pool, preparing it
+   * on this connection if that was not done yet
+   *
+   * @throws std::invalid_argument if the statement was never registered
+   *
+   * @param name
+   * @return pqxx::prepped
+   */
+  pqxx::prepped statement(const std::string& name);
+
+  /**
+   * @brief Marks the connection as broken, so the pool closes it instead of
+   * handing it out again
+   *
+   */
+  void invalidate();
+
+private:
+  friend struct ConnectionPool;
+
+  PooledConnection(ConnectionPool* pool,
+      std::unique_ptr<pqxx::connection>&& connection,
+      PreparedNames&& prepared);
+
+  ConnectionPool* pool_;
+  std::unique_ptr<pqxx::connection> connection_;
+  PreparedNames prepared_;
+  bool broken_ = false;
+};
+
+/**
+ * @brief Keeps between min_size and max_size persistent PostgreSQL
+ * connections open, so that historizer operations do not pay for the
+ * connection setup
+ *
+ * Connections that stayed idle longer than the health check interval are
+ * probed before being handed out, broken connections are closed and replaced
+ * on demand.
+ *
+ */
+struct ConnectionPool {
+  explicit ConnectionPool(const ConnectionPoolConfig& config);
+
+  ~ConnectionPool();
+
+  /**
+   * @brief Borrow a healthy connection, opens a new one if all open
+   * connections are in use and max_size is not yet reached
+   *
+   * @throws ConnectionPoolExhausted if no connection became available within
+   * the configured acquire timeout
+   * @throws pqxx::broken_connection if a new connection could not be opened
+   *
+   * @return PooledConnection
+   */
+  PooledConnection acquire();
+
+  /**
+   * @brief Number of currently open connections, including borrowed ones
+   *
+   * @return size_t
+   */
+  size_t size() const;
+
+  /**
+   * @brief Number of open connections that are waiting to be borrowed
+   *
+   * @return size_t
+   */
+  size_t idleCount() const;
+
+  /**
+   * @brief Register a statement, that every connection prepares on its first
+   * use, registering an already known name replaces its definition for
+   * connections that have not prepared it yet
+   *
+   * @param name
+   * @param sql
+   */
+  void registerStatement(const std::string& name, const std::string& sql);
+
+private:
+  friend struct PooledConnection;
+
+  struct IdleConnection {
+    std::unique_ptr<pqxx::connection> connection;
+    PreparedNames prepared;
+    std::chrono::steady_clock::time_point released_at;
+  };
+
+  std::unique_ptr<pqxx::connection> connect() const;
+
+  bool isHealthy(const IdleConnection& idle) const;
+
+  std::string statementSql(const std::string& name) const;
+
+  void release(std::unique_ptr<pqxx::connection>&& connection,
+      PreparedNames&& prepared, bool broken);
+
+  void replenish();
+
+  ConnectionPoolConfig config_;
+  HaSLL::LoggerPtr logger_;
+  mutable std::mutex mx_;
+  std::condition_variable available_;
+  std::deque<IdleConnection> idle_;
+  size_t open_ = 0;
+  mutable std::shared_mutex statements_mx_;
+  std::unordered_map<std::string, std::string> statements_;
+};
+
+using ConnectionPoolPtr = std::unique_ptr<ConnectionPool>;
+
+/**
+ * @brief Runs the given operation with a borrowed connection, broken
+ * connections are handed back as invalid, so the pool replaces them
+ */
+template <typename Operation>
+auto runWithSession(ConnectionPool* pool, Operation& operation) {
+  auto session = pool->acquire();
+  try {
+    return operation(session);
+  } catch (const pqxx::broken_connection&) {
+    session.invalidate();
+    throw;
+  }
+}
+
+/**
+ * @brief Runs the given operation with a pooled connection and retries it
+ * once with a fresh connection, if the first one was dropped by the server
+ */
+template <typename Operation>
+auto withSession(ConnectionPool* pool, Operation&& operation) {
+  try {
+    return runWithSession(pool, operation);
+  } catch (const pqxx::broken_connection&) {
+    return runWithSession(pool, operation);
+  }
+}
+} // namespace open62541
+#endif //__OPEN62541_CONNECTION_POOL_HPP
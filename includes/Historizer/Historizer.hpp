@@ -1,18 +1,37 @@
 #ifndef __OPEN62541_HISTORIZER_HPP
 #define __OPEN62541_HISTORIZER_HPP
 
+#include "BatchWriter.hpp"
+#include "ConnectionPool.hpp"
 #include "HistorianBits.hpp"
+#include "HistorizerConfig.hpp"
+#include "HistorizerUtils.hpp"
 #include "HistoryResult.hpp"
+#include "PartitionManager.hpp"
+#include "RetentionManager.hpp"
 
 #include <HaSLL/Logger.hpp>
 #include <open62541/plugin/historydatabase.h>
 #include <pqxx/pqxx>
 
 #include <filesystem>
+#include <regex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace open62541 {
+struct NodeRegistration {
+  // not owned, must outlive the registration call
+  UA_NodeId node_id;
+  const UA_DataType* type;
+  bool sampled = true;
+};
+
 struct Historizer {
-  Historizer();
+  explicit Historizer(const HistorizerConfig& config = HistorizerConfig());
 
   ~Historizer() = default;
 
@@ -23,13 +42,32 @@ struct Historizer {
    * @see
    * https://github.com/open62541/open62541/blob/master/plugins/historydata/ua_history_data_gathering_default.c#L59
    *
+   * @param sampled - false for nodes, whose values are written into the
+   * node, the server passes those values to the history database itself, so
+   * no UA_MonitoredItem is created for them
+   */
+  UA_StatusCode registerNodeId(UA_Server* server, UA_NodeId node_id,
+      const UA_DataType* type, bool sampled = true);
+
+  /**
+   * @brief Register all given nodes with a single database transaction, the
+   * data change monitored items are created after it was committed
+   *
+   * @return UA_StatusCode - the first failed status or UA_STATUSCODE_GOOD
    */
-  UA_StatusCode registerNodeId(
-      UA_Server* server, UA_NodeId node_id, const UA_DataType* type);
+  UA_StatusCode registerNodeIds(
+      UA_Server* server, const std::vector<NodeRegistration>& nodes);
 
+  /**
+   * @brief Queue the given value for historization, the value is written into
+   * the database asynchronously by the BatchWriter
+   *
+   */
   void write(const UA_NodeId* node_id, UA_Boolean historizing,
       const UA_DataValue* value) const;
 
+  WriterMetrics writerMetrics() const;
+
   void dataChanged(const UA_NodeId* node_id, UA_UInt32 attribute_id,
       const UA_DataValue* value) const;
 
@@ -49,13 +87,86 @@ struct Historizer {
       UA_HistoryReadResponse* response,
       UA_HistoryData* const* const history_data) const;
 
+  /**
+   * @brief Calculate OPC UA Part 13 aggregates within the database, the
+   * supported aggregates are Average, Minimum, Maximum, Count, Start, End,
+   * Delta, TimeAverage and Interpolative
+   *
+   */
+  void readProcessed(const UA_RequestHeader* request_header,
+      const UA_ReadProcessedDetails* history_read_details,
+      UA_TimestampsToReturn timestamps_to_return,
+      UA_Boolean release_continuation_points, size_t nodes_to_read_size,
+      const UA_HistoryReadValueId* nodes_to_read,
+      UA_HistoryReadResponse* response,
+      UA_HistoryData* const* const history_data) const;
+
 private:
+  struct HistorizedNode {
+    NodeStorage storage;
+    NodeStatements statements;
+  };
+
+  /**
+   * @brief Get the storage and prepared statement names of the given node,
+   * the storage is looked up and the statements are registered with the
+   * connection pool on first use
+   *
+   * @throws NoData if the node was never registered for historization
+   */
+  HistorizedNode historizedNode(const std::string& table) const;
+
+  /**
+   * @brief Remember the storage of the given node, statements are registered
+   * anew, if the storage changed
+   *
+   */
+  HistorizedNode addHistorizedNode(
+      const std::string& table, const NodeStorage& storage) const;
+
+  NodeStorage lookupStorage(const std::string& table) const;
+
+  /**
+   * @brief Add the Historized_Nodes entry and history table of the given node
+   * within the given transaction
+   *
+   */
+  NodeStorage createNodeStorage(pqxx::work& transaction,
+      const std::string& target, const UA_DataType* type) const;
+
+  UA_StatusCode monitorNode(UA_Server* server, const NodeRegistration& node,
+      const std::string& target);
+
+  /**
+   * @brief Parameters of the first monitoring rule, that matches the given
+   * node and data type, or the default parameters
+   *
+   */
+  const MonitoringParameters& monitoringParameters(
+      const std::string& table, const UA_DataType* type) const;
+
   HistoryResults readHistory(
       const UA_ReadRawModifiedDetails* history_read_details,
       UA_UInt32 timeout_hint, UA_TimestampsToReturn timestamps_to_return,
       UA_NodeId node_id, const UA_ByteString* continuation_point_in,
       UA_ByteString* continuation_point_out) const;
 
+  /**
+   * @brief Read raw values at the requested Unix epoch microseconds, values
+   * between samples are interpolated
+   *
+   * @throws NoData if the node has no values
+   * @throws NoBoundData if a requested timestamp has no bounding values
+   */
+  std::pair<UA_StatusCode, HistoryResults> readAtTimes(
+      const NodeStatements& statements, const std::vector<int64_t>& requested,
+      UA_TimestampsToReturn timestamps_to_return) const;
+
+  UA_StatusCode readAggregate(
+      const UA_ReadProcessedDetails* history_read_details, Aggregate aggregate,
+      UA_TimestampsToReturn timestamps_to_return, UA_NodeId node_id,
+      UA_HistoryData* history_data) const;
+
   UA_StatusCode readAndAppendHistory(
       const UA_ReadAtTimeDetails* history_read_details, UA_UInt32 timeout_hint,
       UA_TimestampsToReturn timestamps_to_return, UA_NodeId node_id,
@@ -63,7 +174,19 @@ private:
       UA_ByteString* continuation_point_out, UA_HistoryData*) const;
 
   HaSLL::LoggerPtr logger_;
+  StorageConfig storage_;
+  MonitoringConfig monitoring_;
+  ProcessedReadConfig processed_;
+  std::vector<std::regex> monitoring_patterns_;
+  ConnectionPoolPtr pool_;
+  PartitionManagerPtr partitions_;
+  RetentionManagerPtr retention_;
+  // declared after pool_, so pending values are flushed before the pool closes
+  BatchWriterPtr writer_;
   std::unordered_map<int64_t, UA_DataTypeKind> type_map_;
+  mutable std::shared_mutex nodes_mx_;
+  mutable std::unordered_map<std::string, HistorizedNode> nodes_;
+  mutable size_t registered_nodes_ = 0;
 };
 
 using HistorizerPtr = std::shared_ptr<Historizer>;
@@ -0,0 +1,193 @@
+#ifndef __OPEN62541_HISTORIZER_CONFIG_HPP
+#define __OPEN62541_HISTORIZER_CONFIG_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace open62541 {
+struct ConnectionPoolConfig {
+  /**
+   * @brief libpq connection string, by default the
+   * stag_open62541_historizer service from pg_service.conf is used
+   *
+   */
+  std::string connection = "service=stag_open62541_historizer";
+  size_t min_size = 1;
+  size_t max_size = 8; // NOLINT(readability-magic-numbers)
+  std::chrono::milliseconds acquire_timeout = std::chrono::seconds(5);
+  std::chrono::milliseconds health_check_interval = std::chrono::seconds(30);
+};
+
+/**
+ * @brief Defines what happens to a new value, when the write queue is full
+ *
+ */
+enum class OverflowPolicy : uint8_t {
+  Block, /*!< wait until the writer thread frees up space in the queue */
+  DropOldest, /*!< discard the oldest queued value */
+  SpillToDisk /*!< append the value to the spill file, it is written into
+                 the database once the queue has drained */
+};
+
+struct WriterConfig {
+  // boost::lockfree fixed sized queues can not hold more than 65535 entries
+  size_t queue_capacity = 65535; // NOLINT(readability-magic-numbers)
+  size_t batch_size = 1000; // NOLINT(readability-magic-numbers)
+  std::chrono::milliseconds flush_interval = std::chrono::milliseconds(500);
+  OverflowPolicy overflow_policy = OverflowPolicy::DropOldest;
+  std::filesystem::path spill_file = "historizer.spill";
+};
+
+/**
+ * @brief Defines how the historized values are stored in the database
+ *
+ */
+enum class StorageLayout : uint8_t {
+  TablePerNode, /*!< every historized node gets its own table */
+  Partitioned /*!< nodes share one table per value type, that is range
+                 partitioned by the source timestamp */
+};
+
+struct StorageConfig {
+  StorageLayout layout = StorageLayout::TablePerNode;
+  /**
+   * @brief Time range covered by a single partition of the Partitioned
+   * layout
+   *
+   */
+  std::chrono::hours partition_interval = std::chrono::hours(24);
+  /**
+   * @brief Partitions that end before now - retention are dropped, 0 keeps
+   * all partitions. Only used by the Partitioned layout
+   *
+   */
+  std::chrono::hours retention = std::chrono::hours(0);
+};
+
+/**
+ * @brief Downsampled copy of the historized values, that holds the sample
+ * count, minimum, maximum and average value of every interval
+ *
+ */
+struct RollupTier {
+  std::chrono::seconds interval = std::chrono::minutes(1);
+  /**
+   * @brief Rollups older than this are deleted, 0 keeps them forever
+   *
+   */
+  std::chrono::hours retention = std::chrono::hours(0);
+};
+
+/**
+ * @brief Retention of the historized values of all nodes, whose sanitized
+ * node id matches the pattern
+ *
+ */
+struct RetentionPolicy {
+  /**
+   * @brief ECMAScript regular expression, that must match the entire
+   * sanitized node id
+   *
+   */
+  std::string pattern = ".*";
+  /**
+   * @brief Raw values older than this are deleted, 0 keeps them forever
+   *
+   */
+  std::chrono::hours max_age = std::chrono::hours(0);
+  /**
+   * @brief Only the newest max_rows raw values are kept, 0 keeps all values
+   *
+   */
+  size_t max_rows = 0;
+  /**
+   * @brief Rollup tiers of numeric nodes, the interval of every tier must be
+   * a multiple of the previous tier interval. Raw values and the previous
+   * tier must be retained for at least two intervals of a tier
+   *
+   */
+  std::vector<RollupTier> rollups;
+};
+
+struct RetentionConfig {
+  std::chrono::milliseconds maintenance_interval = std::chrono::minutes(5);
+  /**
+   * @brief The first matching policy is applied to a node, nodes without a
+   * matching policy keep all of their values
+   *
+   */
+  std::vector<RetentionPolicy> policies;
+};
+
+enum class DeadbandType : uint8_t {
+  None, /*!< every value change is reported */
+  Absolute, /*!< changes smaller than the deadband value are ignored */
+  Percent /*!< changes smaller than the deadband value percent of the
+             EURange property are ignored */
+};
+
+/**
+ * @brief Parameters of the monitored item, that historizes a node
+ *
+ */
+struct MonitoringParameters {
+  double sampling_interval = 10000.0; // NOLINT(readability-magic-numbers)
+  DeadbandType deadband_type = DeadbandType::None;
+  double deadband_value = 0.0;
+  uint32_t queue_size = 1;
+  bool discard_oldest = true;
+};
+
+struct MonitoringRule {
+  /**
+   * @brief ECMAScript regular expression, that must match the entire
+   * sanitized node id
+   *
+   */
+  std::string pattern = ".*";
+  /**
+   * @brief OPC UA data type name, for example Double, empty matches all data
+   * types
+   *
+   */
+  std::string data_type;
+  MonitoringParameters parameters;
+};
+
+struct MonitoringConfig {
+  /**
+   * @brief Used for nodes without a matching rule
+   *
+   */
+  MonitoringParameters defaults;
+  /**
+   * @brief The first rule, that matches both the node id and the data type,
+   * is applied to a node
+   *
+   */
+  std::vector<MonitoringRule> rules;
+};
+
+struct ProcessedReadConfig {
+  /**
+   * @brief Processed reads, that would calculate more processing intervals
+   * per node, are rejected with Bad_TooManyOperations
+   *
+   */
+  size_t max_intervals = 10000; // NOLINT(readability-magic-numbers)
+};
+
+struct HistorizerConfig {
+  ConnectionPoolConfig pool;
+  WriterConfig writer;
+  StorageConfig storage;
+  RetentionConfig retention;
+  MonitoringConfig monitoring;
+  ProcessedReadConfig processed;
+};
+} // namespace open62541
+#endif //__OPEN62541_HISTORIZER_CONFIG_HPP
@@ -1,58 +1,327 @@
 #ifndef __OPEN62541_HISTORIZER_UTILS_HPP
 #define __OPEN62541_HISTORIZER_UTILS_HPP
 
+#include "ConnectionPool.hpp"
 #include "HistoryResult.hpp"
 
 #include <open62541/types.h>
 #include <open62541/types_generated.h>
 #include <pqxx/pqxx>
 
+#include <array>
+#include <chrono>
 #include <cstdint>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
 
 namespace open62541 {
 
-void createDomainRestrictions(pqxx::connection session);
+void createDomainRestrictions(pqxx::work* transaction);
 
 using TypeMap = std::unordered_map<int64_t, UA_DataTypeKind>;
 
-TypeMap queryTypeOIDs(pqxx::connection session);
+TypeMap queryTypeOIDs(pqxx::work* transaction);
 
-std::string getCurrentTimestamp();
+/**
+ * @brief Converts UA_DateTime into microseconds since the Unix epoch, the
+ * form in which timestamps are passed as statement parameters
+ */
+int64_t toUnixMicroseconds(UA_DateTime timestamp);
+
+UA_DateTime toUaDateTime(int64_t unix_microseconds);
+
+/**
+ * @brief SQL expression, that converts a Unix epoch microseconds parameter
+ * into a TIMESTAMP on the database side
+ *
+ * @param parameter - statement parameter placeholder, for example $1
+ * @return std::string
+ */
+std::string fromUnixMicroseconds(const std::string& parameter);
+
+/**
+ * @brief OPC UA Part 13 aggregates, supported by HistoryReadProcessed
+ *
+ */
+enum class Aggregate : uint8_t {
+  Average,
+  Minimum,
+  Maximum,
+  Count,
+  Start,
+  End,
+  Delta,
+  TimeAverage,
+  Interpolative
+};
+
+// Interpolative is resolved with the at_times statement
+constexpr size_t CALCULATED_AGGREGATES =
+    static_cast<size_t>(Aggregate::Interpolative);
+
+/**
+ * @brief Map an aggregate function node id to the Aggregate
+ *
+ * @param aggregate_type
+ * @return std::optional<Aggregate> - std::nullopt for unsupported aggregates
+ */
+std::optional<Aggregate> toAggregate(const UA_NodeId& aggregate_type);
+
+/**
+ * @brief Where the values of a single historized node are stored
+ *
+ */
+struct NodeStorage {
+  /**
+   * @brief Quoted name of the table, that holds the node values
+   *
+   */
+  std::string relation;
+  /**
+   * @brief Historized_Nodes key, that identifies the node values within a
+   * shared table, std::nullopt if the node has a table of its own
+   *
+   */
+  std::optional<int32_t> node_key;
+};
+
+/**
+ * @brief Name of the shared, time partitioned table for values of the given
+ * SQL type
+ *
+ * @param sql_type - as returned by toSqlType()
+ * @return std::string
+ */
+std::string toHistoryTable(const std::string& sql_type);
+
+/**
+ * @brief Relation and node filter of a FROM clause, the returned string ends
+ * with an open WHERE clause, that the caller continues with its own filters
+ *
+ * @param storage
+ * @return std::string
+ */
+std::string selectFrom(const NodeStorage& storage);
+
+/**
+ * @brief Shared table, that holds the rollup tiers of all nodes
+ *
+ */
+constexpr auto ROLLUP_TABLE = "History_Rollups";
+
+/**
+ * @brief Rollup tier of a single node, that the shared rollup statements
+ * read
+ *
+ */
+struct RollupKey {
+  /**
+   * @brief Sanitized node id of the historized node
+   *
+   */
+  std::string node_id;
+  int32_t interval_seconds;
+};
+
+/**
+ * @brief Names of the prepared statements, used to read a single historized
+ * node
+ *
+ * read_forward and read_backward take the lower and upper Unix epoch
+ * microseconds bounds, the include bounds flag, the Source_Timestamp as Unix
+ * epoch microseconds and the Index of the last value of the previous page and
+ * a nullable row limit as parameters. The
+ * at_times statement takes an array of Unix epoch microseconds and returns
+ * the exact matches or the bounding values of every requested timestamp,
+ * ordered by the position of the timestamp in the array.
+ *
+ * Aggregate statements take the lower and upper Unix epoch microseconds
+ * bounds and the processing interval in microseconds, they return the
+ * Bucket_Micros, Sample_Count and Value of every processing interval in
+ * ascending order. Aggregates are only prepared on request, since they fail
+ * to prepare for tables with non numeric values.
+ *
+ */
+struct NodeStatements {
+  std::string read_forward;
+  std::string read_backward;
+  std::string at_times;
+  std::array<std::string, CALCULATED_AGGREGATES> aggregates;
+  /**
+   * @brief Set for rollup statements, its Node_ID and Interval_Seconds are
+   * passed after the parameters of every statement, see addRollupKey()
+   *
+   */
+  std::optional<RollupKey> rollup;
+};
+
+/**
+ * @brief Registers the read statements of the given node storage with the
+ * connection pool
+ *
+ * @param pool
+ * @param storage - table and key of the historized node
+ * @param prefix - unique statement name prefix, prepared statement names are
+ * limited to 63 characters, so node ids can not be used as names
+ * @return NodeStatements
+ */
+NodeStatements registerNodeStatements(ConnectionPool* pool,
+    const NodeStorage& storage, const std::string& prefix);
+
+/**
+ * @brief Registers the read statements of the rollup tiers with the
+ * connection pool, the statements are shared by all nodes and tiers, that
+ * are selected by the RollupKey parameters
+ *
+ * Raw reads return the interval averages. Only the Average, Minimum, Maximum
+ * and Count aggregates can be calculated from a rollup tier, the remaining
+ * aggregate statement names are left empty.
+ *
+ * @param pool
+ * @param prefix - unique statement name prefix
+ * @return NodeStatements - without a rollup key
+ */
+NodeStatements registerRollupStatements(
+    ConnectionPool* pool, const std::string& prefix);
+
+/**
+ * @brief Appends the rollup key parameters of the given statements, if they
+ * are rollup statements
+ *
+ */
+void addRollupKey(pqxx::params* values, const NodeStatements& statements);
+
+void prepareNodeStatements(
+    PooledConnection* session, const NodeStatements& statements);
 
 std::string toSanitizedString(const UA_NodeId* node_id);
 
 void addNodeValue(pqxx::params* values, const UA_Variant* variant);
 
-std::string setColumnNames(UA_TimestampsToReturn timestamps_to_return);
+/**
+ * @brief Checks if the given variant holds a scalar of a type, that can be
+ * stored in a historizer table
+ */
+bool isHistorizable(const UA_Variant* variant);
 
-std::string setColumnFilters(
-    UA_Boolean include_bounds, UA_DateTime start_time, UA_DateTime end_time);
+/**
+ * @brief Checks if values of the given type can be converted into FLOAT8 by
+ * the database, only such nodes can be rolled up
+ */
+bool isNumeric(const UA_DataType* type);
 
-std::string setColumnFilters(UA_Boolean include_bounds, UA_DateTime start_time,
-    UA_DateTime end_time, const UA_ByteString* continuation_point);
+/**
+ * @brief Writes a Source_Timestamp, Server_Timestamp, Value row for the given
+ * data value into a COPY stream, the row starts with the Node_Key column, if
+ * a node key is given
+ *
+ * @throws std::logic_error if the value type is not supported
+ */
+void streamNodeValue(pqxx::stream_to* stream, const UA_DataValue* value,
+    std::optional<int32_t> node_key = std::nullopt);
 
+/**
+ * @brief Parses a "%F %T" formatted database timestamp value with up to
+ * microseconds precision
+ *
+ * @throws std::logic_error if the timestamp can not be parsed
+ */
 UA_DateTime toUaDateTime(const std::string& data);
 
 UA_Variant toUaVariant(const pqxx::field& data, const TypeMap& type_map);
 
-UA_ByteString* makeContinuationPoint(intmax_t last_index);
+/**
+ * @brief Key of the last value of a raw history read page, the next page
+ * starts after it
+ *
+ */
+struct ContinuationPoint {
+  int64_t source_micros;
+  int64_t index;
+};
 
-HistoryResult makeHistoryResult(const pqxx::row& entry,
-    UA_TimestampsToReturn timestamps_to_return, const TypeMap& type_map);
+UA_ByteString makeContinuationPoint(const ContinuationPoint& position);
+
+/**
+ * @brief Decode a continuation point, created by makeContinuationPoint()
+ *
+ * @throws std::invalid_argument if the continuation point is malformed
+ *
+ * @param continuation_point
+ * @return std::optional<ContinuationPoint> - std::nullopt for an empty
+ * continuation point
+ */
+std::optional<ContinuationPoint> readContinuationPoint(
+    const UA_ByteString* continuation_point);
 
-HistoryResults makeHistoryResults(const pqxx::result& rows,
+/**
+ * @brief Sets the requested timestamps of the given data value
+ *
+ */
+void setTimestamps(UA_DataValue* data_value,
+    UA_TimestampsToReturn timestamps_to_return, UA_DateTime source_timestamp,
+    UA_DateTime server_timestamp);
+
+/**
+ * @brief Decodes the Value, Source_Micros and Server_Micros columns of the
+ * given row directly into a new value of the given results
+ *
+ */
+void appendHistoryResult(HistoryResults* results, const pqxx::row& entry,
     UA_TimestampsToReturn timestamps_to_return, const TypeMap& type_map);
 
-HistoryResult interpolateValues(UA_DateTime target_timestamp,
-    const HistoryResult& before, const HistoryResult& after);
+/**
+ * @brief Linearly interpolate a value at the target time from its bounding
+ * values, as defined in OPC UA Part 13 Aggregates specification section
+ * 3.1.8
+ *
+ * Integer values are interpolated in 128 bit integer arithmetic, so 64 bit
+ * values keep their full precision, and rounded half away from zero.
+ * Bounding values with the same timestamp return the value before target.
+ *
+ * @throws std::logic_error if bounding values are not numeric or their types
+ * do not match
+ *
+ * @param target - Unix epoch microseconds of the interpolated value
+ * @param before_time - Unix epoch microseconds of the value before target
+ * @param before
+ * @param after_time - Unix epoch microseconds of the value after target
+ * @param after
+ * @return UA_Variant
+ */
+UA_Variant interpolateValue(int64_t target, int64_t before_time,
+    const UA_Variant& before, int64_t after_time, const UA_Variant& after);
 
+/**
+ * @brief Moves the given data values to the end of the given history data
+ * and frees the data_points array, the data values are deleted, if they
+ * could not be appended
+ *
+ */
 UA_StatusCode appendUADataValue(
     UA_HistoryData* result, UA_DataValue* data_points, size_t data_points_size);
 
+/**
+ * @brief Replace the values of the given history data with the given index
+ * range of them, values without data in the range are replaced by a
+ * Bad_IndexRangeNoData status
+ *
+ * @param index_range - NumericRange string of the HistoryReadValueId, an
+ * empty string keeps the values unchanged
+ * @return UA_StatusCode - UA_STATUSCODE_BADINDEXRANGEINVALID if the index
+ * range can not be parsed
+ */
+UA_StatusCode selectIndexRange(
+    UA_HistoryData* result, const UA_String& index_range);
+
+/**
+ * @brief Hands the values of the given results over to the given history
+ * data, the results are empty afterwards
+ *
+ */
 UA_StatusCode expandHistoryResult(
-    UA_HistoryData* result, const HistoryResults& rows);
+    UA_HistoryData* result, HistoryResults&& rows);
 } // namespace open62541
 #endif //__OPEN62541_HISTORIZER_UTILS_HPP
\ No newline at end of file
@@ -3,20 +3,67 @@
 
 #include <open62541/types.h>
 
-#include <cstdint>
-#include <string>
-#include <vector>
+#include <cstddef>
 
 namespace open62541 {
-struct HistoryResult {
-  int64_t index; // pqxx does not return size_t from queries, also we use -1
-                 // for interpolated values
-  UA_Variant value;
-  std::string source_timestamp;
-  std::string server_timestamp;
-};
+/**
+ * @brief Values of a history read, decoded directly into one contiguous
+ * UA_DataValue array, that is handed over to the UA_HistoryData of the
+ * response without converting or copying the values again
+ *
+ * Values, that were not released, are cleared by the destructor, so a failed
+ * read does not leak already decoded values.
+ *
+ */
+struct HistoryResults {
+  HistoryResults() = default;
+
+  ~HistoryResults();
+
+  HistoryResults(const HistoryResults&) = delete;
+  HistoryResults& operator=(const HistoryResults&) = delete;
+
+  HistoryResults(HistoryResults&& other) noexcept;
+  HistoryResults& operator=(HistoryResults&& other) noexcept;
+
+  /**
+   * @brief Allocates room for the given number of values, so appending them
+   * does not reallocate the array
+   *
+   * @throws OutOfMemory if the array could not be allocated
+   */
+  void reserve(size_t capacity);
+
+  /**
+   * @brief Appends an empty data value, that the caller fills in place
+   *
+   * @throws OutOfMemory if the array could not be grown
+   */
+  UA_DataValue& append();
+
+  size_t size() const { return size_; }
 
-using HistoryResults = std::vector<HistoryResult>;
+  bool empty() const { return size_ == 0; }
+
+  UA_DataValue& back() { return values_[size_ - 1]; }
+
+  void reverse();
+
+  /**
+   * @brief Hands the values over to the caller, who must delete them with
+   * UA_Array_delete(), the results are empty afterwards
+   *
+   * @return UA_DataValue* - nullptr if there are no values
+   */
+  UA_DataValue* release();
+
+private:
+  void clear();
+
+  UA_DataValue* values_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+};
 } // namespace open62541
 
-#endif //__OPEN62541_HISTORY_RESULT_HPP
\ No newline at end of file
+#endif //__OPEN62541_HISTORY_RESULT_HPP
@@ -0,0 +1,70 @@
+#ifndef __OPEN62541_PARTITION_MANAGER_HPP
+#define __OPEN62541_PARTITION_MANAGER_HPP
+
+#include "ConnectionPool.hpp"
+#include "HistorizerConfig.hpp"
+
+#include <HaSLL/Logger.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace open62541 {
+/**
+ * @brief Creates and drops the time range partitions of the shared history
+ * tables, used by the Partitioned StorageLayout
+ *
+ * Partitions are aligned to multiples of the partition interval since the
+ * Unix epoch and are named after the table and the partition start, for
+ * example History_DOUBLE_PRECISION_p2024010100. Expired partitions are
+ * dropped as a whole, instead of deleting their rows.
+ *
+ */
+struct PartitionManager {
+  PartitionManager(ConnectionPool* pool, const StorageConfig& config);
+
+  /**
+   * @brief Create the partitions of the given table, that cover the given
+   * source timestamps, if they do not exist yet. Also drops expired
+   * partitions, if the last retention check was more than an hour ago
+   *
+   * @param relation - shared history table name, as returned by
+   * toHistoryTable()
+   * @param source_micros - Unix epoch microseconds of the values, that are
+   * about to be written
+   */
+  void ensurePartitions(
+      const std::string& relation, const std::vector<int64_t>& source_micros);
+
+  /**
+   * @brief Drop all partitions of the known history tables, that end before
+   * now - retention
+   *
+   * @return size_t - number of dropped partitions
+   */
+  size_t dropExpired();
+
+private:
+  int64_t intervalMicros() const;
+
+  void createPartition(const std::string& relation, int64_t start_micros);
+
+  size_t removeExpired();
+
+  ConnectionPool* pool_;
+  StorageConfig config_;
+  HaSLL::LoggerPtr logger_;
+  std::mutex mx_;
+  std::unordered_set<std::string> relations_;
+  std::unordered_set<std::string> partitions_;
+  std::chrono::steady_clock::time_point next_retention_check_;
+};
+
+using PartitionManagerPtr = std::unique_ptr<PartitionManager>;
+} // namespace open62541
+#endif //__OPEN62541_PARTITION_MANAGER_HPP
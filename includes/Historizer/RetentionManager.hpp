@@ -0,0 +1,123 @@
+#ifndef __OPEN62541_RETENTION_MANAGER_HPP
+#define __OPEN62541_RETENTION_MANAGER_HPP
+
+#include "ConnectionPool.hpp"
+#include "HistorizerConfig.hpp"
+#include "HistorizerUtils.hpp"
+
+#include <HaSLL/Logger.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace open62541 {
+/**
+ * @brief Bounds the growth of the historized data and maintains the rollup
+ * tiers of the historized nodes
+ *
+ * A background thread periodically rolls up the new values of every tracked
+ * numeric node into its rollup tiers, each tier is calculated from the
+ * previous one, and afterwards deletes the raw values and rollups, that
+ * exceed the retention of the matching RetentionPolicy.
+ *
+ * Reads can use the rollup tiers, once they have been calculated for the
+ * requested time range.
+ *
+ */
+struct RetentionManager {
+  /**
+   * @throws std::invalid_argument if the rollup tier intervals of a policy
+   * are not ascending multiples of each other or the values, that a tier is
+   * calculated from, are retained for less than two of its intervals
+   * @throws std::regex_error if a policy pattern is not a valid regular
+   * expression
+   */
+  RetentionManager(ConnectionPool* pool, const RetentionConfig& config);
+
+  ~RetentionManager();
+
+  /**
+   * @brief Apply the first matching retention policy to the given node, nodes
+   * without a matching policy are ignored
+   *
+   * @param table - sanitized node id of the historized node
+   * @param storage - table and key of the historized node
+   * @param numeric - only numeric nodes are rolled up
+   */
+  void track(
+      const std::string& table, const NodeStorage& storage, bool numeric);
+
+  /**
+   * @brief Get the statements of the finest rollup tier, that covers the
+   * given time range, if the raw values of that time range already expired
+   *
+   * @return std::optional<NodeStatements> - std::nullopt if the raw values
+   * should be read
+   */
+  std::optional<NodeStatements> rollupForRaw(const std::string& table,
+      int64_t lower_micros, int64_t upper_micros) const;
+
+  /**
+   * @brief Get the statements of the coarsest rollup tier, that can
+   * calculate the given aggregate for the given time range and processing
+   * interval
+   *
+   * @return std::optional<NodeStatements> - std::nullopt if the aggregate
+   * should be calculated from the raw values
+   */
+  std::optional<NodeStatements> rollupForAggregate(const std::string& table,
+      Aggregate aggregate, int64_t lower_micros, int64_t upper_micros,
+      int64_t width_micros) const;
+
+  /**
+   * @brief Roll up and apply the retention policies of all tracked nodes
+   *
+   */
+  void runMaintenance();
+
+private:
+  struct Tier {
+    RollupTier config;
+    // rollup intervals, that start before this, contain all values
+    int64_t complete_until = INT64_MIN;
+  };
+
+  struct TrackedNode {
+    NodeStorage storage;
+    size_t policy;
+    std::vector<Tier> tiers;
+  };
+
+  void run();
+
+  void maintain(const std::string& table, const TrackedNode& node);
+
+  NodeStatements rollupStatements(
+      const std::string& table, const Tier& tier) const;
+
+  ConnectionPool* pool_;
+  RetentionConfig config_;
+  HaSLL::LoggerPtr logger_;
+  std::vector<std::regex> patterns_;
+  mutable std::shared_mutex nodes_mx_;
+  std::unordered_map<std::string, TrackedNode> nodes_;
+  NodeStatements rollup_statements_;
+  std::atomic<bool> running_ = true;
+  std::mutex wake_mx_;
+  std::condition_variable wake_;
+  std::thread thread_;
+};
+
+using RetentionManagerPtr = std::unique_ptr<RetentionManager>;
+} // namespace open62541
+#endif //__OPEN62541_RETENTION_MANAGER_HPP
@@ -2,6 +2,7 @@
 #define __OPEN62541_CALLBACK_REPOSITORY_HPP
 
 #include "NodeId.hpp"
+#include "ReadDispatcher.hpp"
 
 #include <HaSLL/Logger.hpp>
 #include <Information_Model/Callable.hpp>
@@ -11,11 +12,17 @@
 #include <boost/unordered/concurrent_node_map.hpp>
 #include <open62541/server.h>
 
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <variant>
+#include <vector>
 
 template <> class boost::hash<open62541::NodeId> {
 public:
@@ -50,28 +57,171 @@ using CallbackWrapper = std::variant< // clang-format off
         Information_Model::CallablePtr
     >; // clang-format on
 
-struct CallbackRepo {
-  using CallbackMap = boost::concurrent_node_map<NodeId, CallbackWrapper>;
+struct CallbackRepo;
+
+/**
+ * @brief Callbacks of a single node, passed to open62541 as the node
+ * context, so callbacks are dispatched without looking up the node id
+ *
+ * Records are owned by the CallbackRepo and keep their address until the
+ * repo is destroyed. A removed record is only reused, once no callback is
+ * using it and it spent a quarantine period unused, since the server could
+ * have fetched its pointer just before the node was deleted.
+ *
+ */
+struct CallbackRecord {
+  struct CachedRead {
+    std::shared_future<Information_Model::DataVariant> value;
+    std::chrono::steady_clock::time_point requested;
+    UA_DateTime source_timestamp = 0;
+  };
+
+  CallbackRepo* repo = nullptr;
+  std::string device_id;
+  CallbackWrapper wrapper;
+  ReadLimits limits;
+  std::mutex cache_mx;
+  CachedRead cache;
+  /**
+   * @brief Last successful read, returned while a newer read is in flight,
+   * if it is within the max_age and stale_age of the node
+   *
+   */
+  CachedRead last;
+  std::atomic<size_t> in_flight = 0;
+  std::atomic<bool> removed = false;
+  std::chrono::steady_clock::time_point removed_at;
+};
 
-  CallbackRepo();
+struct CallbackRepo {
+  using CallbackMap = boost::concurrent_node_map<NodeId, CallbackRecord*>;
+  using ObserverMap =
+      boost::concurrent_node_map<NodeId, Information_Model::ObserverPtr>;
+  using DeviceMap =
+      boost::concurrent_node_map<std::string, std::vector<NodeId>>;
+
+  /**
+   * @throws std::regex_error if a read timeout rule pattern is not a valid
+   * regular expression
+   */
+  explicit CallbackRepo(
+      const ReadDispatcherConfig& config = ReadDispatcherConfig());
   ~CallbackRepo() = default;
 
-  UA_StatusCode add(UA_NodeId node_id, const CallbackWrapper& wrapper);
+  /**
+   * @brief Register the callbacks of the given node
+   *
+   * @param device_id - device, that owns the node, its nodes can be removed
+   * at once with removeDevice()
+   */
+  UA_StatusCode add(UA_NodeId node_id, const CallbackWrapper& wrapper,
+      const std::string& device_id = "");
+
+  /**
+   * @brief Get the node context of the given node, that must be passed to
+   * open62541, when the node is created
+   *
+   * @return void* - CallbackRecord of the node or nullptr if the node has no
+   * callbacks
+   */
+  void* nodeContext(const UA_NodeId& node_id);
 
   void remove(const UA_NodeId* node_id);
 
-  UA_StatusCode read(const UA_NodeId* node_id, UA_DataValue* value);
-
-  UA_StatusCode write(const UA_NodeId* node_id, const UA_DataValue* value);
-
-  UA_StatusCode execute(const UA_NodeId* method_id, size_t input_size,
-      const UA_Variant* input, size_t output_size, UA_Variant* output);
+  /**
+   * @brief Remove the callbacks of all nodes, that were added for the given
+   * device
+   *
+   * @return size_t - number of removed nodes
+   */
+  size_t removeDevice(const std::string& device_id);
+
+  /**
+   * @brief Read the value of the given node. Readable and Writable nodes are
+   * read on a worker thread and reuse the value of an earlier or concurrent
+   * read, that is not older than the max age of the node
+   *
+   * @param include_source_timestamp - set the source timestamp to the time
+   * of the device read
+   * @param range - index range of a string or byte string value, that is
+   * read, nullptr or an empty range reads the whole value
+   */
+  UA_StatusCode read(CallbackRecord* record, const UA_NodeId* node_id,
+      UA_DataValue* value, bool include_source_timestamp = false,
+      const UA_NumericRange* range = nullptr);
+
+  UA_StatusCode write(CallbackRecord* record, const UA_NodeId* node_id,
+      const UA_DataValue* value);
+
+  /**
+   * @brief Execute the Callable of the given method node. Methods with a
+   * result are called asynchronously and cancelled, if the result is not
+   * available within the given timeout
+   *
+   * @param timeout - time to wait for the result, std::nullopt waits until
+   * the result is available
+   */
+  UA_StatusCode execute(CallbackRecord* record, const UA_NodeId* method_id,
+      size_t input_size, const UA_Variant* input, size_t output_size,
+      UA_Variant* output,
+      std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+
+  /**
+   * @brief Subscribe to the Observable of the given node and write every
+   * notified value into the node, so it reaches subscriptions and the
+   * Historizer without polling the device. The subscription ends, once the
+   * node is removed
+   *
+   */
+  UA_StatusCode observe(UA_Server* server, const UA_NodeId* node_id);
 
 private:
   CallbackWrapper find(const UA_NodeId* node_id);
 
+  /**
+   * @brief Take a free record or allocate a new one, after reclaiming the
+   * records, whose quarantine is over
+   *
+   */
+  CallbackRecord* allocate();
+
+  /**
+   * @brief Quarantine the given record, that was already erased from the
+   * callbacks map, and end the subscription of its node
+   *
+   */
+  void release(const NodeId& node_id, CallbackRecord* record);
+
+  /**
+   * @brief Run the given reader on a worker thread, unless the cached read of
+   * the given node is still in flight or within its max age
+   *
+   * While a read is in flight, the last successful value of the node is
+   * returned immediately. Only a node without such a value waits for the read
+   * timeout of the node, which blocks the server thread for that long.
+   *
+   * @param source_timestamp - set to the time, when the returned value was
+   * requested from the device
+   * @return std::optional<Information_Model::DataVariant> - std::nullopt if
+   * the read timed out
+   */
+  std::optional<Information_Model::DataVariant> dispatch(
+      CallbackRecord* record, const UA_NodeId* node_id,
+      ReadDispatcher::Reader&& reader, UA_DateTime& source_timestamp);
+
+  void update(UA_Server* server, const NodeId& node_id,
+      Information_Model::DataType type,
+      const Information_Model::DataVariant& value);
+
   CallbackMap callbacks_;
+  ObserverMap observers_;
+  DeviceMap devices_;
   HaSLL::LoggerPtr logger_;
+  ReadDispatcherPtr dispatcher_;
+  std::mutex records_mx_;
+  std::deque<CallbackRecord> records_;
+  std::vector<CallbackRecord*> free_records_;
+  std::deque<CallbackRecord*> quarantined_records_;
 };
 using CallbackRepoPtr = std::shared_ptr<CallbackRepo>;
 
@@ -4,6 +4,9 @@
 #ifdef ENABLE_UA_HISTORIZING
 #include "Historizer.hpp"
 #endif // ENABLE_UA_HISTORIZING
+#include "ReadDispatcher.hpp"
+#include "RegistrationPipeline.hpp"
+#include "Runner.hpp"
 
 #include <HaSLL/Logger.hpp>
 #include <open62541/server.h>
@@ -19,12 +22,18 @@ struct Configuration {
   ~Configuration() = default;
 
   std::unique_ptr<UA_ServerConfig> getConfig();
+  ReadDispatcherConfig getReadDispatcherConfig() const;
+  RunnerConfig getRunnerConfig() const;
+  RegistrationConfig getRegistrationConfig() const;
 #ifdef ENABLE_UA_HISTORIZING
   HistorizerPtr getHistorizer() const;
 #endif // ENABLE_UA_HISTORIZING
 
 private:
   HaSLL::LoggerPtr logger_;
+  ReadDispatcherConfig read_dispatcher_;
+  RunnerConfig runner_;
+  RegistrationConfig registration_;
 #ifdef ENABLE_UA_HISTORIZING
   HistorizerPtr historizer_;
 #endif // ENABLE_UA_HISTORIZING
@@ -12,9 +12,20 @@
 #include <Information_Model/Writable.hpp>
 #include <open62541/server.h>
 
+#include <deque>
 #include <memory>
+#include <string>
 
 namespace open62541 {
+struct PlannedNode;
+/**
+ * @brief Node tree of a device, that was built in memory, but not yet added
+ * to the server
+ *
+ */
+struct DevicePlan;
+using DevicePlanPtr = std::shared_ptr<DevicePlan>;
+
 struct NodeBuilder {
   NodeBuilder(const CallbackRepoPtr& repo,
 #ifdef ENABLE_UA_HISTORIZING
@@ -23,43 +34,72 @@ struct NodeBuilder {
       UA_Server* server);
   ~NodeBuilder() = default;
 
+  /**
+   * @brief Build the node tree of the given device in memory and read the
+   * initial values of its Observable nodes. Does not touch the server, so
+   * multiple devices can be prepared in parallel
+   *
+   */
+  DevicePlanPtr prepareDeviceNode(
+      const Information_Model::DevicePtr& device) const;
+
+  /**
+   * @brief Add the nodes of the given device. The node tree is built in
+   * memory before it is added to the server, if any node or the
+   * historization of the device fails, all nodes of the device are removed
+   * again
+   *
+   */
   UA_StatusCode addDeviceNode(const Information_Model::DevicePtr& device);
+
+  /**
+   * @brief Add the nodes of a prepared device, if any node or the
+   * historization of the device fails, all nodes of the device are removed
+   * again
+   *
+   */
+  UA_StatusCode addDeviceNode(const DevicePlanPtr& plan);
   UA_StatusCode deleteDeviceNode(const std::string& device_id);
 
 private:
-  UA_NodeId addObjectNode(const Information_Model::MetaInfoPtr& element,
-      const std::optional<UA_NodeId>& parent_node_id = std::nullopt);
+  /**
+   * @brief Read the initial values of the planned observable nodes in
+   * parallel
+   *
+   */
+  void readInitialValues(std::deque<PlannedNode>& plan) const;
 
-  UA_StatusCode addElementNode(
-      const Information_Model::ElementPtr& device_element,
-      const UA_NodeId& parent_id);
+  UA_StatusCode addPlannedNode(
+      PlannedNode& planned, const std::string& device_id);
 
-  UA_StatusCode addGroupNode(const Information_Model::MetaInfoPtr& meta_info,
-      const Information_Model::GroupPtr& device_element_group,
-      const UA_NodeId& parent_id);
+  UA_StatusCode addObjectNode(const PlannedNode& planned);
 
-  UA_StatusCode addReadableNode(const Information_Model::MetaInfoPtr& meta_info,
+  UA_StatusCode addReadableNode(PlannedNode& planned,
       const Information_Model::ReadablePtr& readable,
-      const UA_NodeId& parent_id);
+      const std::string& device_id);
 
-  UA_StatusCode addObservableNode(
-      const Information_Model::MetaInfoPtr& meta_info,
+  UA_StatusCode addObservableNode(PlannedNode& planned,
       const Information_Model::ObservablePtr& observable,
-      const UA_NodeId& parent_id);
+      const std::string& device_id);
 
-  UA_StatusCode addWritableNode(const Information_Model::MetaInfoPtr& meta_info,
+  UA_StatusCode addWritableNode(PlannedNode& planned,
       const Information_Model::WritablePtr& writable,
-      const UA_NodeId& parent_id);
+      const std::string& device_id);
 
-  UA_StatusCode addCallableNode(const Information_Model::MetaInfoPtr& meta_info,
+  UA_StatusCode addCallableNode(const PlannedNode& planned,
       const Information_Model::CallablePtr& callable,
-      const UA_NodeId& parent_id);
-
-  UA_StatusCode removeDataSources(const UA_NodeId* node_id);
+      const std::string& device_id);
 
 #ifdef ENABLE_UA_HISTORIZING
-  void historize(UA_NodeId node_id, const UA_DataType* type);
-#endif
+  /**
+   * @brief Register all historized nodes of the given plan with a single
+   * Historizer call
+   *
+   * @return UA_StatusCode - the first failed registration status or
+   * UA_STATUSCODE_GOOD
+   */
+  UA_StatusCode historize(const std::deque<PlannedNode>& plan);
+#endif // ENABLE_UA_HISTORIZING
 
   HaSLL::LoggerPtr logger_;
   CallbackRepoPtr repo_;
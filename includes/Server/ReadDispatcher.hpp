@@ -0,0 +1,128 @@
+#ifndef __OPEN62541_READ_DISPATCHER_HPP
+#define __OPEN62541_READ_DISPATCHER_HPP
+
+#include <HaSLL/Logger.hpp>
+#include <Information_Model/DataVariant.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace open62541 {
+struct ReadLimits {
+  /**
+   * @brief Reads, that take longer than this, fail with BadTimeout
+   *
+   * Reads are answered on the server thread, so a read, that waits for the
+   * device, blocks the whole server for up to this long
+   *
+   */
+  std::chrono::milliseconds timeout = std::chrono::milliseconds(500);
+  /**
+   * @brief Reads within this time of the last device read return its value
+   * instead of reading the device again, 0 disables the value cache
+   *
+   */
+  std::chrono::milliseconds max_age = std::chrono::milliseconds(0);
+  /**
+   * @brief While the device is read again, reads return the last successful
+   * read value, if it is at most max_age plus this old, instead of waiting
+   * for the device. 0 only returns values within max_age
+   *
+   */
+  std::chrono::milliseconds stale_age = std::chrono::milliseconds(0);
+};
+
+/**
+ * @brief Overrides the read limits of all nodes, whose id matches the
+ * pattern
+ *
+ */
+struct ReadRule {
+  std::string pattern = ".*";
+  ReadLimits limits;
+};
+
+struct ReadDispatcherConfig {
+  /**
+   * @brief Number of threads, that read Readable and Writable nodes, 0 reads
+   * them on the server thread without a timeout
+   *
+   */
+  size_t workers = 4;
+  /**
+   * @brief Reads, that are waiting for a worker, above this are rejected
+   *
+   */
+  size_t queue_capacity = 1024; // NOLINT(readability-magic-numbers)
+  ReadLimits defaults;
+  /**
+   * @brief First matching rule sets the read limits of a node, nodes without
+   * a matching rule use the defaults
+   *
+   */
+  std::vector<ReadRule> rules;
+};
+
+struct ReadQueueFull : std::runtime_error {
+  ReadQueueFull() : std::runtime_error("Read queue is full") {}
+};
+
+/**
+ * @brief Runs device reads on a pool of worker threads, so a slow device
+ * delays only the reads of its own nodes for at most their timeout, instead
+ * of stalling the server thread indefinitely
+ *
+ */
+struct ReadDispatcher {
+  using Reader = std::function<Information_Model::DataVariant()>;
+
+  /**
+   * @throws std::regex_error if a rule pattern is not a valid regular
+   * expression
+   */
+  explicit ReadDispatcher(const ReadDispatcherConfig& config);
+
+  ~ReadDispatcher();
+
+  /**
+   * @brief Get the read limits of the given node
+   *
+   * @param node_id - string representation of the node id
+   */
+  ReadLimits limits(const std::string& node_id) const;
+
+  /**
+   * @brief Queue the given reader for a worker thread. Reader runs on the
+   * calling thread, if there are no workers
+   *
+   * @throws ReadQueueFull if queue_capacity reads are already waiting
+   */
+  std::future<Information_Model::DataVariant> dispatch(Reader&& reader);
+
+private:
+  void run();
+
+  ReadDispatcherConfig config_;
+  HaSLL::LoggerPtr logger_;
+  std::vector<std::regex> patterns_;
+  bool running_ = true;
+  std::mutex queue_mx_;
+  std::condition_variable queued_;
+  std::deque<std::packaged_task<Information_Model::DataVariant()>> queue_;
+  std::vector<std::thread> workers_;
+};
+
+using ReadDispatcherPtr = std::unique_ptr<ReadDispatcher>;
+} // namespace open62541
+#endif //__OPEN62541_READ_DISPATCHER_HPP
@@ -0,0 +1,97 @@
+#ifndef __OPEN62541_REGISTRATION_PIPELINE_HPP
+#define __OPEN62541_REGISTRATION_PIPELINE_HPP
+
+#include "NodeBuilder.hpp"
+
+#include <HaSLL/Logger.hpp>
+#include <Information_Model/Device.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace open62541 {
+struct RegistrationConfig {
+  /**
+   * @brief Number of threads, that prepare device node trees, 0 registers
+   * devices on the calling thread
+   *
+   */
+  size_t workers = 4;
+  /**
+   * @brief Registration events, that were not yet applied, above this block
+   * the caller, until a queued event is applied
+   *
+   */
+  size_t queue_capacity = 256; // NOLINT(readability-magic-numbers)
+};
+
+/**
+ * @brief Applies device registration and deregistration events in the order,
+ * that they were queued in. Node trees of registered devices are prepared by
+ * a pool of worker threads in parallel, only adding the prepared nodes to the
+ * server is serialized
+ *
+ */
+struct RegistrationPipeline {
+  RegistrationPipeline(const std::shared_ptr<NodeBuilder>& builder,
+      const RegistrationConfig& config);
+
+  /**
+   * @brief Applies all queued events before it returns
+   *
+   */
+  ~RegistrationPipeline();
+
+  /**
+   * @brief Queue the given device for registration, blocks while the queue is
+   * full
+   *
+   */
+  void add(const Information_Model::DevicePtr& device);
+
+  /**
+   * @brief Queue the given device for deregistration, it is removed after
+   * all previously queued events were applied
+   *
+   */
+  void remove(const std::string& device_id);
+
+private:
+  struct Event {
+    Information_Model::DevicePtr device;
+    std::string device_id;
+    DevicePlanPtr plan;
+    bool taken = false;
+    bool prepared = false;
+  };
+  using EventPtr = std::shared_ptr<Event>;
+
+  void queue(EventPtr&& event);
+
+  void run();
+
+  void prepare(Event& event);
+
+  void apply(const Event& event);
+
+  HaSLL::LoggerPtr logger_;
+  std::shared_ptr<NodeBuilder> builder_;
+  RegistrationConfig config_;
+  bool running_ = true;
+  // only one worker adds or removes nodes at a time
+  bool applying_ = false;
+  std::mutex queue_mx_;
+  std::condition_variable changed_;
+  std::deque<EventPtr> queue_;
+  std::vector<std::thread> workers_;
+};
+
+using RegistrationPipelinePtr = std::unique_ptr<RegistrationPipeline>;
+} // namespace open62541
+#endif //__OPEN62541_REGISTRATION_PIPELINE_HPP
@@ -1,22 +1,61 @@
 #ifndef __OPEN62541_RUNNER_HPP
 #define __OPEN62541_RUNNER_HPP
 
-#include "Configuration.hpp"
-
 #include <HaSLL/Logger.hpp>
 #include <Information_Model/Device.hpp>
 #include <open62541/server.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 namespace open62541 {
+enum class RunnerMode {
+  /**
+   * @brief The server thread executes the queued async operations between
+   * event loop iterations
+   *
+   */
+  SINGLE_THREAD,
+  /**
+   * @brief The queued async operations are executed by the worker threads.
+   * Only method calls are async, reads, writes and all other services are
+   * still handled by the server thread
+   *
+   */
+  WORKER_POOL
+};
+
+struct RunnerConfig {
+  RunnerMode mode = RunnerMode::WORKER_POOL;
+  /**
+   * @brief Number of threads, that execute the async operations in
+   * WORKER_POOL mode, at least one is always started
+   *
+   */
+  size_t workers = 2;
+};
 
 struct Runner {
-  explicit Runner(UA_ServerConfig* config);
+  /**
+   * @param config - consumed server configuration
+   * @param runner_config - threading of the server
+   */
+  explicit Runner(
+      UA_ServerConfig* config, const RunnerConfig& runner_config = {});
 
   ~Runner();
 
+  /**
+   * @brief Starts the server thread and waits until the server started up
+   *
+   * @return false - if the server failed to start up
+   */
   bool start();
 
   bool stop();
@@ -26,12 +65,37 @@ struct Runner {
   UA_Server* getServer();
 
 private:
-  void runnable();
+  /**
+   * @brief Drive the server event loop with UA_Server_run_iterate(), until
+   * the runner is stopped
+   *
+   * @param startup - receives the result of UA_Server_run_startup()
+   */
+  void runnable(std::promise<UA_StatusCode> startup);
+
+  /**
+   * @brief Take async method calls from the server queue and execute them,
+   * until the server stops
+   *
+   */
+  void processAsyncOperations();
+
+  /**
+   * @brief Execute the next queued async operation
+   *
+   * @return true - if an operation was taken from the queue
+   * @return false - if the queue was empty
+   */
+  bool processAsyncOperation();
 
-  volatile bool running_ = false;
+  std::atomic<bool> running_ = false;
   UA_Server* server_;
+  RunnerConfig config_;
   std::thread thread_;
+  std::mutex workers_mx_;
+  std::condition_variable workers_wake_;
+  std::vector<std::thread> workers_;
   HaSLL::LoggerPtr logger_;
 };
 } // namespace open62541
-#endif //__OPEN62541_RUNNER_HPP
\ No newline at end of file
+#endif //__OPEN62541_RUNNER_HPP
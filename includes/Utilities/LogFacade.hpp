@@ -0,0 +1,90 @@
+#ifndef __OPEN62541_UTILITY_LOG_FACADE_HPP
+#define __OPEN62541_UTILITY_LOG_FACADE_HPP
+
+#include <HaSLL/Logger.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+namespace open62541 {
+/**
+ * @brief Lowest severity, that the OPEN62541_* logging macros pass on to
+ * HaSLL. Log sites below it do not evaluate their arguments
+ *
+ */
+inline std::atomic<HaSLL::SeverityLevel> log_threshold =
+    HaSLL::SeverityLevel::Trace;
+
+/**
+ * @brief Set the lowest severity, that is passed on to HaSLL. It should match
+ * the logging_level of the HaSLL configuration, since HaSLL drops lower
+ * severities anyway, but only after their messages were formatted
+ *
+ */
+inline void setLogThreshold(HaSLL::SeverityLevel level) {
+  log_threshold.store(level, std::memory_order_relaxed);
+}
+
+inline bool isLogged(HaSLL::SeverityLevel level) {
+  return level >= log_threshold.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Convert a HaSLL logging_level name, for example "trace" or "info",
+ * into a severity
+ *
+ * @throws std::invalid_argument if the name is unknown
+ */
+inline HaSLL::SeverityLevel toSeverityLevel(const std::string& value) {
+  if (value == "trace") {
+    return HaSLL::SeverityLevel::Trace;
+  } else if (value == "debug") {
+    return HaSLL::SeverityLevel::Debug;
+  } else if (value == "info") {
+    return HaSLL::SeverityLevel::Info;
+  } else if (value == "warning") {
+    return HaSLL::SeverityLevel::Warning;
+  } else if (value == "error") {
+    return HaSLL::SeverityLevel::Error;
+  } else if (value == "critical") {
+    return HaSLL::SeverityLevel::Critical;
+  } else if (value == "off") {
+    return HaSLL::SeverityLevel::Off;
+  }
+  throw std::invalid_argument("Unknown logging level: " + value);
+}
+} // namespace open62541
+
+// NOLINTBEGIN(cppcoreguidelines-macro-usage)
+#define OPEN62541_LOG_IF(level, call)                                          \
+  do {                                                                         \
+    if (::open62541::isLogged(HaSLL::SeverityLevel::level)) {                  \
+      call;                                                                    \
+    }                                                                          \
+  } while (false)
+
+#ifdef OPEN62541_STRIP_DEBUG_LOGS
+// arguments are still compiled, so variables used only for logging stay used,
+// but never evaluated and the calls are removed as dead code
+#define OPEN62541_TRACE(logger, ...)                                           \
+  do {                                                                         \
+    if (false) {                                                               \
+      (logger)->trace(__VA_ARGS__);                                            \
+    }                                                                          \
+  } while (false)
+#define OPEN62541_DEBUG(logger, ...)                                           \
+  do {                                                                         \
+    if (false) {                                                               \
+      (logger)->debug(__VA_ARGS__);                                            \
+    }                                                                          \
+  } while (false)
+#else
+#define OPEN62541_TRACE(logger, ...)                                           \
+  OPEN62541_LOG_IF(Trace, (logger)->trace(__VA_ARGS__))
+#define OPEN62541_DEBUG(logger, ...)                                           \
+  OPEN62541_LOG_IF(Debug, (logger)->debug(__VA_ARGS__))
+#endif // OPEN62541_STRIP_DEBUG_LOGS
+// NOLINTEND(cppcoreguidelines-macro-usage)
+
+#endif //__OPEN62541_UTILITY_LOG_FACADE_HPP
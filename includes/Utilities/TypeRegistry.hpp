@@ -0,0 +1,199 @@
+#ifndef __OPEN62541_UTILITY_TYPE_REGISTRY_HPP
+#define __OPEN62541_UTILITY_TYPE_REGISTRY_HPP
+
+#include <open62541/types.h>
+
+#include <array>
+#include <cstddef>
+
+namespace open62541 {
+/**
+ * @brief Compile time description of a scalar UA_DataType, that the adapter
+ * converts and historizes
+ *
+ * @tparam T - type of the value, that UA_Variant::data points to
+ * @tparam Kind - UA_DataTypeKind of the type
+ * @tparam TypeIndex - UA_TYPES index of the type
+ * @tparam Numeric - true if the type supports arithmetic operators and
+ * numeric aggregates
+ */
+template <typename T, UA_DataTypeKind Kind, size_t TypeIndex, bool Numeric>
+struct UaType {
+  using type = T;
+  static constexpr UA_DataTypeKind kind = Kind;
+  static constexpr size_t type_index = TypeIndex;
+  static constexpr bool numeric = Numeric;
+
+  static const UA_DataType* dataType() { return &UA_TYPES[TypeIndex]; }
+
+  static const T& value(const UA_Variant& variant) {
+    return *static_cast<const T*>(variant.data);
+  }
+};
+
+struct BooleanType
+    : UaType<UA_Boolean, UA_DATATYPEKIND_BOOLEAN, UA_TYPES_BOOLEAN, false> {
+  static constexpr const char* sql_type = "BOOLEAN";
+};
+
+struct SByteType
+    : UaType<UA_SByte, UA_DATATYPEKIND_SBYTE, UA_TYPES_SBYTE, true> {
+  static constexpr const char* sql_type = "OPCUA_TINYINT";
+};
+
+struct ByteType : UaType<UA_Byte, UA_DATATYPEKIND_BYTE, UA_TYPES_BYTE, true> {
+  static constexpr const char* sql_type = "OPCUA_TINYUINT";
+};
+
+struct Int16Type
+    : UaType<UA_Int16, UA_DATATYPEKIND_INT16, UA_TYPES_INT16, true> {
+  static constexpr const char* sql_type = "SMALLINT";
+};
+
+struct UInt16Type
+    : UaType<UA_UInt16, UA_DATATYPEKIND_UINT16, UA_TYPES_UINT16, true> {
+  static constexpr const char* sql_type = "OPCUA_SMALLUINT";
+};
+
+struct Int32Type
+    : UaType<UA_Int32, UA_DATATYPEKIND_INT32, UA_TYPES_INT32, true> {
+  static constexpr const char* sql_type = "INT";
+};
+
+struct UInt32Type
+    : UaType<UA_UInt32, UA_DATATYPEKIND_UINT32, UA_TYPES_UINT32, true> {
+  static constexpr const char* sql_type = "OPCUA_UINT";
+};
+
+struct Int64Type
+    : UaType<UA_Int64, UA_DATATYPEKIND_INT64, UA_TYPES_INT64, true> {
+  static constexpr const char* sql_type = "BIGINT";
+};
+
+struct UInt64Type
+    : UaType<UA_UInt64, UA_DATATYPEKIND_UINT64, UA_TYPES_UINT64, true> {
+  static constexpr const char* sql_type = "OPCUA_BIGUINT";
+};
+
+struct FloatType
+    : UaType<UA_Float, UA_DATATYPEKIND_FLOAT, UA_TYPES_FLOAT, true> {
+  static constexpr const char* sql_type = "REAL";
+};
+
+struct DoubleType
+    : UaType<UA_Double, UA_DATATYPEKIND_DOUBLE, UA_TYPES_DOUBLE, true> {
+  static constexpr const char* sql_type = "DOUBLE PRECISION";
+};
+
+struct StatusCodeType
+    : UaType<UA_StatusCode, UA_DATATYPEKIND_STATUSCODE, UA_TYPES_STATUSCODE,
+          false> {
+  static constexpr const char* sql_type = "OPCUA_STATUSCODE";
+};
+
+struct DateTimeType
+    : UaType<UA_DateTime, UA_DATATYPEKIND_DATETIME, UA_TYPES_DATETIME, false> {
+  static constexpr const char* sql_type = "TIMESTAMP(6)";
+};
+
+struct ByteStringType
+    : UaType<UA_ByteString, UA_DATATYPEKIND_BYTESTRING, UA_TYPES_BYTESTRING,
+          false> {
+  static constexpr const char* sql_type = "BYTEA";
+};
+
+struct StringType
+    : UaType<UA_String, UA_DATATYPEKIND_STRING, UA_TYPES_STRING, false> {
+  static constexpr const char* sql_type = "TEXT";
+};
+
+template <typename... Types> struct TypeList {};
+
+/**
+ * @brief All scalar types, that are converted from and into UA_Variant
+ * values, a type is supported by every converter once it is added here
+ *
+ */
+using ScalarTypes = TypeList<BooleanType, SByteType, ByteType, Int16Type,
+    UInt16Type, Int32Type, UInt32Type, Int64Type, UInt64Type, FloatType,
+    DoubleType, StatusCodeType, DateTimeType, ByteStringType, StringType>;
+
+constexpr size_t TYPE_KINDS = UA_DATATYPEKINDS;
+
+/**
+ * @brief Jump table from UA_DataTypeKind to an operation, kinds without an
+ * operation hold nullptr
+ *
+ */
+template <typename Signature>
+using DispatchTable = std::array<Signature*, TYPE_KINDS>;
+
+template <typename Signature, template <typename> class Operation,
+    bool NumericOnly, typename Type>
+constexpr void addOperation(DispatchTable<Signature>& table) {
+  if constexpr (!NumericOnly || Type::numeric) {
+    table[Type::kind] = &Operation<Type>::apply;
+  }
+}
+
+/**
+ * @brief Generate a jump table, that calls Operation<Type>::apply for the
+ * UA_DataTypeKind of each listed type
+ *
+ * @tparam NumericOnly - skip types, that are not numeric
+ */
+template <typename Signature, template <typename> class Operation,
+    bool NumericOnly = false, typename... Types>
+constexpr DispatchTable<Signature> makeDispatchTable(
+    TypeList<Types...> /*types*/) {
+  DispatchTable<Signature> table{};
+  (addOperation<Signature, Operation, NumericOnly, Types>(table), ...);
+  return table;
+}
+
+/**
+ * @brief Operation of the given type or nullptr, if the type has none
+ *
+ */
+template <typename Signature>
+Signature* dispatch(const DispatchTable<Signature>& table, size_t kind) {
+  return kind < TYPE_KINDS ? table[kind] : nullptr;
+}
+
+template <typename Signature>
+Signature* dispatch(
+    const DispatchTable<Signature>& table, const UA_DataType* type) {
+  return type == nullptr ? nullptr : dispatch(table, type->typeKind);
+}
+
+struct TypeInfo {
+  bool registered;
+  bool numeric;
+  const char* sql_type;
+};
+
+template <typename... Types>
+constexpr std::array<TypeInfo, TYPE_KINDS> makeTypeInfo(
+    TypeList<Types...> /*types*/) {
+  std::array<TypeInfo, TYPE_KINDS> result{};
+  ((result[Types::kind] = TypeInfo{true, Types::numeric, Types::sql_type}),
+      ...);
+  return result;
+}
+
+inline constexpr auto TYPE_INFO = makeTypeInfo(ScalarTypes{});
+
+/**
+ * @brief Registered properties of the given type, types, that are not listed
+ * in ScalarTypes, are not registered
+ *
+ */
+inline TypeInfo typeInfo(const UA_DataType* type) {
+  if (type == nullptr || type->typeKind >= TYPE_KINDS) {
+    return TypeInfo{false, false, nullptr};
+  }
+  return TYPE_INFO[type->typeKind];
+}
+} // namespace open62541
+
+#endif //__OPEN62541_UTILITY_TYPE_REGISTRY_HPP
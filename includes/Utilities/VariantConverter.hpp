@@ -28,11 +28,52 @@ UA_NodeId toNodeId(Information_Model::DataType type);
  */
 UA_Variant toUAVariant(const Information_Model::DataVariant& variant);
 
+/**
+ * @brief Convert a given Information Model variant directly into the given
+ * UA_Variant, for example the value of a UA_DataValue or a method output.
+ * Strings and byte strings are copied into a single buffer, that the
+ * UA_Variant owns
+ *
+ * @attention Previous content of the target is not cleared, resulting content
+ * must be cleared by the owner of the target, when it is no longer needed
+ *
+ * @throws std::bad_alloc if the value could not be allocated
+ * @throws std::runtime_error if the variant holds an unsupported type
+ *
+ * @param variant
+ * @param target
+ */
+void toUAVariant(
+    const Information_Model::DataVariant& variant, UA_Variant* target);
+
+/**
+ * @brief Convert the given index range of a string or byte string Information
+ * Model variant into the given UA_Variant, only the selected bytes are copied.
+ * Ranges past the end of the value are cut at the last byte
+ *
+ * @attention Previous content of the target is not cleared, resulting content
+ * must be cleared by the owner of the target, when it is no longer needed
+ *
+ * @throws std::bad_alloc if the value could not be allocated
+ *
+ * @param variant
+ * @param range
+ * @param target
+ * @return UA_StatusCode - UA_STATUSCODE_BADINDEXRANGEINVALID if the range
+ * bounds are reversed, UA_STATUSCODE_BADINDEXRANGENODATA if the variant is not
+ * a string or byte string or the range does not select any of its bytes
+ */
+UA_StatusCode toUAVariant(const Information_Model::DataVariant& variant,
+    const UA_NumericRange& range, UA_Variant* target);
+
 /**
  * @brief Convert a given UA_Variant into an Information Model variant
  *
  * @attention Given UA_Variant content is not cleared
  *
+ * @throws std::runtime_error if the variant is not a scalar or holds an
+ * unsupported type
+ *
  * @param variant
  * @return Information_Model::DataVariant
  */
@@ -1,5 +1,7 @@
 #include "Open62541Adapter.hpp"
+#include "Configuration.hpp"
 #include "NodeBuilder.hpp"
+#include "RegistrationPipeline.hpp"
 #include "Runner.hpp"
 
 namespace Data_Consumer_Adapter {
@@ -10,12 +12,13 @@ using namespace Information_Model;
 struct OpcuaAdapter : public DataConsumerAdapter {
   OpcuaAdapter(const DataConnector& connector, const filesystem::path& config)
       : DataConsumerAdapter("OPC_UA_Adapter", connector) {
-    repo_ = make_shared<CallbackRepo>();
-
     auto runner_config = make_unique<open62541::Configuration>(config);
+    repo_ = make_shared<CallbackRepo>(runner_config->getReadDispatcherConfig());
 #ifdef ENABLE_UA_HISTORIZING
     historizer_ = runner_config->getHistorizer();
 #endif // ENABLE_UA_HISTORIZING
+    auto threading = runner_config->getRunnerConfig();
+    auto registration = runner_config->getRegistrationConfig();
     /* Config is consumed, so no need to save it
      * Inside UA_runner_newWithConfig assigns the config as follows
      *      server->config = *config;
@@ -23,12 +26,14 @@ struct OpcuaAdapter : public DataConsumerAdapter {
      *      memset(config, 0, sizeof(UA_ServerConfig));
      * this mimics cpp std::move()
      */
-    runner_ = make_shared<Runner>(runner_config->getConfig().get());
-    builder_ = make_unique<NodeBuilder>(repo_,
+    runner_ =
+        make_shared<Runner>(runner_config->getConfig().get(), threading);
+    builder_ = make_shared<NodeBuilder>(repo_,
 #ifdef ENABLE_UA_HISTORIZING
         historizer_,
 #endif // ENABLE_UA_HISTORIZING
         runner_->getServer());
+    registrations_ = make_unique<RegistrationPipeline>(builder_, registration);
   }
 
   ~OpcuaAdapter() override = default;
@@ -57,7 +62,7 @@ private:
         "OPC UA Adapter received NEW_DEVICE_REGISTERED event for device "
         "with id",
         device->id());
-    builder_->addDeviceNode(device);
+    registrations_->add(device);
   }
 
   void deregistrate(const string& device_id) override {
@@ -65,7 +70,7 @@ private:
         "OPC UA Adapter received DEVICE_REMOVED event for device with id "
         "{}",
         device_id);
-    builder_->deleteDeviceNode(device_id);
+    registrations_->remove(device_id);
   }
 
   CallbackRepoPtr repo_;
@@ -73,7 +78,9 @@ private:
   HistorizerPtr historizer_;
 #endif // ENABLE_UA_HISTORIZING
   shared_ptr<Runner> runner_;
-  unique_ptr<NodeBuilder> builder_;
+  shared_ptr<NodeBuilder> builder_;
+  // declared after builder_, so queued events are applied before it is gone
+  RegistrationPipelinePtr registrations_;
 };
 
 DataConsumerAdapterPtr makeOpen62541Adapter(
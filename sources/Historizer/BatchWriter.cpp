@@ -0,0 +1,458 @@
+#include "BatchWriter.hpp"
+#include "HistorizerUtils.hpp"
+#include "LogFacade.hpp"
+
+#include <HaSLL/LoggerManager.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+namespace open62541 {
+using namespace std;
+using namespace HaSLL;
+using namespace pqxx;
+
+// boost::lockfree fixed sized queues use 16 bit node indexes
+constexpr size_t MAX_QUEUE_CAPACITY = 65535;
+// delay spill file replays after a failed flush, so an unreachable database
+// does not make us replay and re-spill the same values in a loop
+constexpr auto SPILL_REPLAY_DELAY = chrono::seconds(5);
+
+size_t checkCapacity(size_t capacity) {
+  return clamp(capacity, size_t{1}, MAX_QUEUE_CAPACITY);
+}
+
+void writeRecord(ofstream* file, const UA_ByteString& buffer) {
+  auto length = static_cast<uint32_t>(buffer.length);
+  file->write(reinterpret_cast<const char*>(&length), sizeof(length));
+  file->write(reinterpret_cast<const char*>(buffer.data), length);
+}
+
+/**
+ * @brief Appends the binary encoded node id and value of a sample to the
+ * given file
+ *
+ * @return false if the sample could not be encoded or written
+ */
+bool writeSample(
+    ofstream* file, const UA_NodeId& node_id, const UA_DataValue& value) {
+  UA_ByteString node_id_buffer = UA_BYTESTRING_NULL;
+  UA_ByteString value_buffer = UA_BYTESTRING_NULL;
+  auto status =
+      UA_encodeBinary(&node_id, &UA_TYPES[UA_TYPES_NODEID], &node_id_buffer);
+  if (status == UA_STATUSCODE_GOOD) {
+    status = UA_encodeBinary(
+        &value, &UA_TYPES[UA_TYPES_DATAVALUE], &value_buffer);
+  }
+  if (status == UA_STATUSCODE_GOOD) {
+    writeRecord(file, node_id_buffer);
+    writeRecord(file, value_buffer);
+  }
+  UA_ByteString_clear(&node_id_buffer);
+  UA_ByteString_clear(&value_buffer);
+  return status == UA_STATUSCODE_GOOD && static_cast<bool>(*file);
+}
+
+bool readRecord(ifstream* file, UA_ByteString* buffer) {
+  uint32_t length = 0;
+  if (!file->read(reinterpret_cast<char*>(&length), sizeof(length))) {
+    return false;
+  }
+  UA_ByteString_clear(buffer);
+  if (UA_ByteString_allocBuffer(buffer, length) != UA_STATUSCODE_GOOD) {
+    return false;
+  }
+  return static_cast<bool>(
+      file->read(reinterpret_cast<char*>(buffer->data), length));
+}
+
+BatchWriter::BatchWriter(ConnectionPool* pool, const WriterConfig& config,
+    StorageResolver resolver, PartitionManager* partitions)
+    : config_(config), pool_(pool), resolver_(move(resolver)),
+      partitions_(partitions),
+      logger_(LoggerManager::registerLogger("Open62541::BatchWriter")),
+      queue_(checkCapacity(config.queue_capacity)) {
+  if (config_.queue_capacity != checkCapacity(config_.queue_capacity)) {
+    logger_->warning("Write queue capacity {} is not supported, using {} "
+                     "instead",
+        config_.queue_capacity, checkCapacity(config_.queue_capacity));
+    config_.queue_capacity = checkCapacity(config_.queue_capacity);
+  }
+  if (config_.batch_size == 0) {
+    config_.batch_size = 1;
+  }
+  error_code error;
+  auto replay_file = config_.spill_file;
+  replay_file += ".replay";
+  // values spilled during the previous run are written on startup
+  has_spill_ = filesystem::exists(config_.spill_file, error) ||
+      filesystem::exists(replay_file, error);
+  thread_ = thread(&BatchWriter::run, this);
+}
+
+BatchWriter::~BatchWriter() {
+  running_ = false;
+  wake_.notify_all();
+  space_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void BatchWriter::release(Sample* sample) {
+  UA_NodeId_clear(&sample->node_id);
+  UA_DataValue_clear(&sample->value);
+}
+
+void BatchWriter::push(const UA_NodeId* node_id, const UA_DataValue* value) {
+  Sample sample;
+  UA_NodeId_init(&sample.node_id);
+  UA_DataValue_init(&sample.value);
+  if (UA_NodeId_copy(node_id, &sample.node_id) != UA_STATUSCODE_GOOD ||
+      UA_DataValue_copy(value, &sample.value) != UA_STATUSCODE_GOOD) {
+    release(&sample);
+    ++dropped_;
+    return;
+  }
+  // both timestamps are stored as NOT NULL, use the time of arrival, if the
+  // value does not carry them
+  if (!sample.value.hasServerTimestamp) {
+    sample.value.serverTimestamp = UA_DateTime_now();
+    sample.value.hasServerTimestamp = true;
+  }
+  if (!sample.value.hasSourceTimestamp) {
+    sample.value.sourceTimestamp = sample.value.serverTimestamp;
+    sample.value.hasSourceTimestamp = true;
+  }
+
+  if (!tryPush(sample)) {
+    overflow(sample);
+  }
+}
+
+bool BatchWriter::tryPush(const Sample& sample) {
+  // counted before the push, so the writer thread never pops a value, that
+  // is not counted yet, and the depth can not wrap around
+  auto depth = ++depth_;
+  if (!queue_.bounded_push(sample)) {
+    --depth_;
+    return false;
+  }
+  if (depth == config_.batch_size) {
+    wake_.notify_one();
+  }
+  return true;
+}
+
+void BatchWriter::overflow(Sample sample) {
+  switch (config_.overflow_policy) {
+  case OverflowPolicy::Block: {
+    unique_lock lock(wake_mx_);
+    wake_.notify_one();
+    while (!tryPush(sample)) {
+      if (!running_) {
+        release(&sample);
+        ++dropped_;
+        return;
+      }
+      space_.wait_for(lock, config_.flush_interval);
+    }
+    break;
+  }
+  case OverflowPolicy::DropOldest: {
+    Sample oldest;
+    while (!tryPush(sample)) {
+      if (queue_.pop(oldest)) {
+        --depth_;
+        release(&oldest);
+        ++dropped_;
+      }
+    }
+    break;
+  }
+  case OverflowPolicy::SpillToDisk:
+  default: {
+    spill({&sample});
+    release(&sample);
+    break;
+  }
+  }
+}
+
+void BatchWriter::spill(const vector<const Sample*>& samples) {
+  lock_guard lock(spill_mx_);
+  // the spill file stays open, until it is replayed
+  if (!spill_stream_.is_open()) {
+    spill_stream_.clear();
+    spill_stream_.open(config_.spill_file, ios::binary | ios::app);
+  }
+  size_t written = 0;
+  for (const auto* sample : samples) {
+    if (spill_stream_ &&
+        writeSample(&spill_stream_, sample->node_id, sample->value)) {
+      ++written;
+    }
+  }
+  spill_stream_.flush();
+  if (!spill_stream_) {
+    // the spill file is opened again by the next spill
+    spill_stream_.close();
+    written = 0;
+  }
+  if (written > 0) {
+    has_spill_ = true;
+  }
+  spilled_ += written;
+  dropped_ += samples.size() - written;
+}
+
+bool BatchWriter::replaySpill(Batches* batches, size_t* pending) {
+  auto replay_file = config_.spill_file;
+  replay_file += ".replay";
+  {
+    lock_guard lock(spill_mx_);
+    has_spill_ = false;
+    error_code error;
+    // a leftover replay file means the last replay was interrupted, finish
+    // it first, new spills are picked up on the next replay
+    if (!filesystem::exists(replay_file, error)) {
+      spill_stream_.close();
+      filesystem::rename(config_.spill_file, replay_file, error);
+      if (error) {
+        return true;
+      }
+      replay_offset_ = 0;
+    }
+  }
+
+  size_t replayed = 0;
+  ifstream file(replay_file, ios::binary);
+  // a replay, that was stopped by a failed flush, continues after the values,
+  // that it already flushed
+  file.seekg(replay_offset_);
+  UA_ByteString node_id_buffer = UA_BYTESTRING_NULL;
+  UA_ByteString value_buffer = UA_BYTESTRING_NULL;
+  while (readRecord(&file, &node_id_buffer) &&
+      readRecord(&file, &value_buffer)) {
+    Sample sample;
+    UA_NodeId_init(&sample.node_id);
+    UA_DataValue_init(&sample.value);
+    auto status = UA_decodeBinary(&node_id_buffer, &sample.node_id,
+        &UA_TYPES[UA_TYPES_NODEID], nullptr);
+    if (status == UA_STATUSCODE_GOOD) {
+      status = UA_decodeBinary(&value_buffer, &sample.value,
+          &UA_TYPES[UA_TYPES_DATAVALUE], nullptr);
+    }
+    if (status != UA_STATUSCODE_GOOD) {
+      release(&sample);
+      ++failed_;
+      continue;
+    }
+    add(batches, sample);
+    ++replayed;
+    if (++(*pending) >= config_.batch_size) {
+      auto flushed = flush(batches);
+      *pending = 0;
+      if (!flushed) {
+        // the failed batch was spilled again, the rest of the file is
+        // replayed, once the database can be reached
+        replay_offset_ = file.tellg();
+        has_spill_ = true;
+        UA_ByteString_clear(&node_id_buffer);
+        UA_ByteString_clear(&value_buffer);
+        logger_->warning("Stopped replaying spilled values after {} values, "
+                         "since the database can not be reached",
+            replayed);
+        return false;
+      }
+    }
+  }
+  UA_ByteString_clear(&node_id_buffer);
+  UA_ByteString_clear(&value_buffer);
+  file.close();
+
+  error_code error;
+  filesystem::remove(replay_file, error);
+  replay_offset_ = 0;
+  logger_->info("Replayed {} spilled values", replayed);
+  return true;
+}
+
+void BatchWriter::run() {
+  Batches batches;
+  size_t pending = 0;
+  auto last_flush = chrono::steady_clock::now();
+  auto replay_after = last_flush;
+  while (running_ || depth_ > 0) {
+    pending += drain(
+        &batches, config_.batch_size - min(pending, config_.batch_size));
+    space_.notify_all();
+
+    auto now = chrono::steady_clock::now();
+    bool interval_elapsed = now - last_flush >= config_.flush_interval;
+    if (pending >= config_.batch_size ||
+        (pending > 0 && (interval_elapsed || !running_))) {
+      if (!flush(&batches)) {
+        replay_after = now + SPILL_REPLAY_DELAY;
+      }
+      pending = 0;
+      last_flush = now;
+      continue;
+    }
+
+    if (pending == 0 && depth_ == 0 && has_spill_ && running_ &&
+        now >= replay_after) {
+      if (!replaySpill(&batches, &pending)) {
+        replay_after = chrono::steady_clock::now() + SPILL_REPLAY_DELAY;
+      }
+      continue;
+    }
+
+    unique_lock lock(wake_mx_);
+    wake_.wait_until(lock, last_flush + config_.flush_interval,
+        [this]() { return !running_ || depth_ >= config_.batch_size; });
+  }
+  flush(&batches);
+}
+
+size_t BatchWriter::drain(Batches* batches, size_t limit) {
+  size_t count = 0;
+  Sample sample;
+  while (count < limit && queue_.pop(sample)) {
+    --depth_;
+    add(batches, sample);
+    ++count;
+  }
+  return count;
+}
+
+void BatchWriter::add(Batches* batches, const Sample& sample) {
+  (*batches)[toSanitizedString(&sample.node_id)].push_back(sample);
+}
+
+bool BatchWriter::flush(Batches* batches) {
+  size_t count = 0;
+  vector<string> tables;
+  // nodes that share a table are written with a single COPY stream
+  unordered_map<string, vector<pair<NodeStorage, const vector<Sample>*>>>
+      relations;
+  for (const auto& [table, samples] : *batches) {
+    if (samples.empty()) {
+      continue;
+    }
+    try {
+      auto storage = resolver_(table);
+      auto relation = storage.relation;
+      relations[relation].emplace_back(move(storage), &samples);
+      tables.push_back(table);
+      count += samples.size();
+    } catch (const exception& ex) {
+      failed_ += samples.size();
+      logger_->error("Failed to historize {} values of {} node. Exception: {}",
+          samples.size(), table, ex.what());
+    }
+  }
+  if (count == 0) {
+    return true;
+  }
+
+  bool success = true;
+  auto start = chrono::steady_clock::now();
+  try {
+    if (partitions_ != nullptr) {
+      for (const auto& [relation, nodes] : relations) {
+        // only the shared tables are partitioned
+        if (!nodes.front().first.node_key.has_value()) {
+          continue;
+        }
+        vector<int64_t> source_micros;
+        for (const auto& [storage, samples] : nodes) {
+          for (const auto& sample : *samples) {
+            source_micros.push_back(
+                toUnixMicroseconds(sample.value.sourceTimestamp));
+          }
+        }
+        partitions_->ensurePartitions(relation, source_micros);
+      }
+    }
+    withSession(pool_, [&relations, &tables](PooledConnection& session) {
+      work transaction(*session);
+      for (const auto& [relation, nodes] : relations) {
+        auto stream = stream_to::raw_table(transaction, relation,
+            nodes.front().first.node_key.has_value()
+                ? "Node_Key, Source_Timestamp, Server_Timestamp, Value"
+                : "Source_Timestamp, Server_Timestamp, Value");
+        for (const auto& [storage, samples] : nodes) {
+          for (const auto& sample : *samples) {
+            streamNodeValue(&stream, &sample.value, storage.node_key);
+          }
+        }
+        stream.complete();
+      }
+      // a single Last_Updated update for all of the nodes in this batch
+      transaction.exec("UPDATE Historized_Nodes SET Last_Updated = " +
+              fromUnixMicroseconds("$1") + " WHERE Node_ID = ANY($2::TEXT[]);",
+          params{toUnixMicroseconds(UA_DateTime_now()), tables});
+      transaction.commit();
+    });
+    written_ += count;
+    OPEN62541_TRACE(logger_,
+        "Historized {} values of {} nodes into {} tables", count,
+        tables.size(), relations.size());
+  } catch (const exception& ex) {
+    // values, that the database rejected, would be rejected by every replay,
+    // so only values, that did not reach the database, are spilled
+    success = dynamic_cast<const broken_connection*>(&ex) == nullptr &&
+        dynamic_cast<const ConnectionPoolExhausted*>(&ex) == nullptr;
+    logger_->error("Failed to historize {} values due to an exception. "
+                   "Exception: {}",
+        count, ex.what());
+    if (!success && config_.overflow_policy == OverflowPolicy::SpillToDisk) {
+      vector<const Sample*> spilled;
+      spilled.reserve(count);
+      for (const auto& [relation, nodes] : relations) {
+        for (const auto& [storage, samples] : nodes) {
+          for (const auto& sample : *samples) {
+            spilled.push_back(&sample);
+          }
+        }
+      }
+      spill(spilled);
+    } else {
+      failed_ += count;
+    }
+  }
+  recordFlushLatency(chrono::duration_cast<chrono::microseconds>(
+      chrono::steady_clock::now() - start));
+
+  for (auto& [table, samples] : *batches) {
+    for (auto& sample : samples) {
+      release(&sample);
+    }
+    samples.clear();
+  }
+  return success;
+}
+
+void BatchWriter::recordFlushLatency(chrono::microseconds latency) {
+  last_flush_latency_ = latency.count();
+  auto max_latency = max_flush_latency_.load();
+  while (latency.count() > max_latency &&
+      !max_flush_latency_.compare_exchange_weak(
+          max_latency, latency.count())) {
+  }
+}
+
+WriterMetrics BatchWriter::metrics() const {
+  WriterMetrics result;
+  result.queue_depth = depth_;
+  result.written = written_;
+  result.dropped = dropped_;
+  result.spilled = spilled_;
+  result.failed = failed_;
+  result.last_flush_latency = chrono::microseconds(last_flush_latency_);
+  result.max_flush_latency = chrono::microseconds(max_flush_latency_);
+  return result;
+}
+} // namespace open62541
@@ -0,0 +1,207 @@
+#include "ConnectionPool.hpp"
+#include "LogFacade.hpp"
+
+#include <HaSLL/LoggerManager.hpp>
+
+namespace open62541 {
+using namespace std;
+using namespace HaSLL;
+
+PooledConnection::PooledConnection(ConnectionPool* pool,
+    unique_ptr<pqxx::connection>&& connection, PreparedNames&& prepared)
+    : pool_(pool), connection_(move(connection)), prepared_(move(prepared)) {}
+
+PooledConnection::PooledConnection(PooledConnection&& other) noexcept
+    : pool_(other.pool_), connection_(move(other.connection_)),
+      prepared_(move(other.prepared_)), broken_(other.broken_) {
+  other.pool_ = nullptr;
+}
+
+PooledConnection::~PooledConnection() {
+  if (pool_ != nullptr && connection_) {
+    pool_->release(move(connection_), move(prepared_), broken_);
+  }
+}
+
+pqxx::connection& PooledConnection::operator*() const { return *connection_; }
+
+pqxx::connection* PooledConnection::operator->() const {
+  return connection_.get();
+}
+
+pqxx::prepped PooledConnection::statement(const string& name) {
+  if (prepared_.find(name) == prepared_.end()) {
+    connection_->prepare(name, pool_->statementSql(name));
+    prepared_.insert(name);
+  }
+  return pqxx::prepped{name};
+}
+
+void PooledConnection::invalidate() { broken_ = true; }
+
+ConnectionPool::ConnectionPool(const ConnectionPoolConfig& config)
+    : config_(config),
+      logger_(LoggerManager::registerLogger("Open62541::ConnectionPool")) {
+  if (config_.max_size == 0) {
+    throw invalid_argument("Connection pool max size can not be 0");
+  }
+  if (config_.min_size > config_.max_size) {
+    logger_->warning("Connection pool min size {} exceeds max size {}. Using "
+                     "max size as min size instead",
+        config_.min_size, config_.max_size);
+    config_.min_size = config_.max_size;
+  }
+  // failing to open the initial connections makes the historizer unusable,
+  // so we let the exception propagate to the caller
+  for (size_t i = 0; i < config_.min_size; ++i) {
+    idle_.push_back(IdleConnection{
+        connect(), PreparedNames{}, chrono::steady_clock::now()});
+    ++open_;
+  }
+  logger_->info("Opened {} database connections", open_);
+}
+
+ConnectionPool::~ConnectionPool() {
+  lock_guard lock(mx_);
+  idle_.clear();
+}
+
+unique_ptr<pqxx::connection> ConnectionPool::connect() const {
+  OPEN62541_TRACE(logger_, "Opening a new database connection");
+  return make_unique<pqxx::connection>(config_.connection);
+}
+
+bool ConnectionPool::isHealthy(const IdleConnection& idle) const {
+  if (!idle.connection || !idle.connection->is_open()) {
+    return false;
+  }
+  auto idle_time = chrono::steady_clock::now() - idle.released_at;
+  if (idle_time < config_.health_check_interval) {
+    return true;
+  }
+  try {
+    pqxx::nontransaction probe(*idle.connection);
+    probe.exec("SELECT 1;");
+    return true;
+  } catch (const pqxx::failure& ex) {
+    logger_->warning("Database connection failed health check: {}", ex.what());
+    return false;
+  }
+}
+
+PooledConnection ConnectionPool::acquire() {
+  auto deadline = chrono::steady_clock::now() + config_.acquire_timeout;
+  unique_lock lock(mx_);
+  while (true) {
+    if (!idle_.empty()) {
+      // reuse the most recently released connection, it is the least likely
+      // one to have been dropped by the server
+      auto idle = move(idle_.back());
+      idle_.pop_back();
+      lock.unlock();
+      if (isHealthy(idle)) {
+        return PooledConnection(
+            this, move(idle.connection), move(idle.prepared));
+      }
+      idle.connection.reset();
+      lock.lock();
+      --open_;
+      logger_->info("Closed a broken database connection");
+      continue;
+    }
+
+    if (open_ < config_.max_size) {
+      ++open_; // reserve the slot before connecting without the lock
+      lock.unlock();
+      try {
+        return PooledConnection(this, connect(), PreparedNames{});
+      } catch (...) {
+        lock.lock();
+        --open_;
+        lock.unlock();
+        available_.notify_one();
+        throw;
+      }
+    }
+
+    if (available_.wait_until(lock, deadline) == cv_status::timeout &&
+        idle_.empty() && open_ >= config_.max_size) {
+      throw ConnectionPoolExhausted();
+    }
+  }
+}
+
+void ConnectionPool::registerStatement(const string& name, const string& sql) {
+  unique_lock lock(statements_mx_);
+  statements_[name] = sql;
+}
+
+string ConnectionPool::statementSql(const string& name) const {
+  shared_lock lock(statements_mx_);
+  auto it = statements_.find(name);
+  if (it == statements_.end()) {
+    throw invalid_argument("Statement " + name + " is not registered");
+  }
+  return it->second;
+}
+
+void ConnectionPool::release(unique_ptr<pqxx::connection>&& connection,
+    PreparedNames&& prepared, bool broken) {
+  bool dropped = broken || !connection->is_open();
+  if (dropped) {
+    connection.reset(); // close without holding the lock
+  }
+  {
+    lock_guard lock(mx_);
+    if (dropped) {
+      --open_;
+    } else {
+      idle_.push_back(IdleConnection{
+          move(connection), move(prepared), chrono::steady_clock::now()});
+    }
+  }
+  available_.notify_one();
+
+  if (dropped) {
+    logger_->info("Closed a broken database connection");
+    replenish();
+  }
+}
+
+void ConnectionPool::replenish() {
+  {
+    lock_guard lock(mx_);
+    if (open_ >= config_.min_size) {
+      return;
+    }
+    ++open_;
+  }
+  try {
+    auto connection = connect();
+    {
+      lock_guard lock(mx_);
+      idle_.push_back(IdleConnection{
+          move(connection), PreparedNames{}, chrono::steady_clock::now()});
+    }
+    available_.notify_one();
+  } catch (const exception& ex) {
+    {
+      lock_guard lock(mx_);
+      --open_;
+    }
+    logger_->warning("Failed to reconnect to the database, will retry on next "
+                     "request. Exception: {}",
+        ex.what());
+  }
+}
+
+size_t ConnectionPool::size() const {
+  lock_guard lock(mx_);
+  return open_;
+}
+
+size_t ConnectionPool::idleCount() const {
+  lock_guard lock(mx_);
+  return idle_.size();
+}
+} // namespace open62541
@@ -2,12 +2,14 @@
 #include "Exceptions.hpp"
 #include "HistorizerUtils.hpp"
 #include "StringConverter.hpp"
-#include "UaVariantOperators.hpp"
 
 #include <HaSLL/LoggerManager.hpp>
 #include <open62541/client_subscriptions.h>
 #include <open62541/server.h>
 
+#include <algorithm>
+#include <cmath>
+#include <optional>
 #include <string>
 
 namespace open62541 {
@@ -31,33 +33,6 @@ struct NoBoundData : runtime_error {
   NoBoundData() : runtime_error("No bound data") {}
 };
 
-pqxx::connection connect() {
-  return connection("service=stag_open62541_historizer");
-}
-
-bool checkTable(const string& name) {
-  auto session = connect();
-  work transaction(session);
-  auto result = transaction.exec(fmt::format(
-      "SELECT 1 FROM information_schema.tables WHERE table_name = {};", name));
-  return !result.empty();
-}
-
-bool isHistorized(const string& node_id) {
-  auto session = connect();
-  work transaction(session);
-  auto result = transaction.exec(fmt::format(
-      "SELECT 1 FROM Historized_Nodes WHERE Node_Id = '{}';", node_id));
-  return !result.empty();
-}
-
-void updateHistorized(work* transaction, const string& target_node_id) {
-  transaction->exec(
-      fmt::format("UPDATE Historized_Nodes SET Last_Updated = '{}' WHERE "
-                  "Node_ID = '{}';",
-          getCurrentTimestamp(), target_node_id));
-}
-
 Historizer* getHistorizer(void* context_ptr) {
   if (context_ptr == nullptr) {
     throw NoHistorizerInContext();
@@ -101,6 +76,21 @@ void setValueCallback(UA_Server*, void* hdb_context, const UA_NodeId*, void*,
   }
 }
 
+/**
+ * @brief Applies the index range of the requested node to the read values
+ *
+ */
+void selectHistoryIndexRange(UA_HistoryReadResult* result,
+    UA_HistoryData* history_data, const UA_HistoryReadValueId& node) {
+  if (UA_StatusCode_isBad(result->statusCode)) {
+    return;
+  }
+  auto status = selectIndexRange(history_data, node.indexRange);
+  if (status != UA_STATUSCODE_GOOD) {
+    result->statusCode = status;
+  }
+}
+
 void readRawCallback(UA_Server*, void* hdb_context, const UA_NodeId*, void*,
     const UA_RequestHeader* request_header,
     const UA_ReadRawModifiedDetails* history_read_details,
@@ -139,17 +129,58 @@ void readAtTimeCallback(UA_Server*, void* hdb_context, const UA_NodeId*, void*,
   }
 }
 
-Historizer::Historizer()
-    : logger_(LoggerManager::registerLogger("Open62541::Historizer")) {
-  auto session = connect();
-  work transaction(session);
-  transaction.exec("CREATE TABLE IF NOT EXISTS Historized_Nodes("
-                   "Node_ID TEXT PRIMARY KEY NOT NULL, "
-                   "Last_Updated TIMESTAMP(6) NOT NULL"
-                   ");");
-  createDomainRestrictions(connect());
-  transaction.commit();
-  type_map_ = queryTypeOIDs(connect());
+void readProcessedCallback(UA_Server*, void* hdb_context, const UA_NodeId*,
+    void*, const UA_RequestHeader* request_header,
+    const UA_ReadProcessedDetails* history_read_details,
+    UA_TimestampsToReturn timestamps_to_return,
+    UA_Boolean release_continuation_points, size_t nodes_to_read_size,
+    const UA_HistoryReadValueId* nodes_to_read,
+    UA_HistoryReadResponse* response,
+    UA_HistoryData* const* const history_data) {
+  try {
+    auto* historizer = getHistorizer(hdb_context);
+    historizer->readProcessed(request_header, history_read_details,
+        timestamps_to_return, release_continuation_points, nodes_to_read_size,
+        nodes_to_read, response, history_data);
+  } catch (...) {
+    response->resultsSize = 1;
+    response->results[0].statusCode = UA_STATUSCODE_BADUNEXPECTEDERROR;
+  }
+}
+
+Historizer::Historizer(const HistorizerConfig& config)
+    : logger_(LoggerManager::registerLogger("Open62541::Historizer")),
+      storage_(config.storage), monitoring_(config.monitoring),
+      processed_(config.processed),
+      pool_(make_unique<ConnectionPool>(config.pool)) {
+  for (const auto& rule : monitoring_.rules) {
+    monitoring_patterns_.emplace_back(rule.pattern);
+  }
+  withSession(pool_.get(), [this](PooledConnection& session) {
+    work transaction(*session);
+    transaction.exec("CREATE TABLE IF NOT EXISTS Historized_Nodes("
+                     "Node_ID TEXT PRIMARY KEY NOT NULL, "
+                     "Last_Updated TIMESTAMP(6) NOT NULL"
+                     ");");
+    // nodes of the Partitioned layout are identified by a small integer key
+    // within the shared History_ tables
+    transaction.exec("ALTER TABLE Historized_Nodes "
+                     "ADD COLUMN IF NOT EXISTS Node_Key INTEGER GENERATED BY "
+                     "DEFAULT AS IDENTITY UNIQUE, "
+                     "ADD COLUMN IF NOT EXISTS History_Table TEXT;");
+    createDomainRestrictions(&transaction);
+    type_map_ = queryTypeOIDs(&transaction);
+    transaction.commit();
+  });
+  if (storage_.layout == StorageLayout::Partitioned) {
+    partitions_ = make_unique<PartitionManager>(pool_.get(), storage_);
+  }
+  if (!config.retention.policies.empty()) {
+    retention_ = make_unique<RetentionManager>(pool_.get(), config.retention);
+  }
+  writer_ = make_unique<BatchWriter>(pool_.get(), config.writer,
+      [this](const string& table) { return historizedNode(table).storage; },
+      partitions_.get());
 }
 
 void Historizer::dataChanged(const UA_NodeId* node_id, UA_UInt32 attribute_id,
@@ -171,52 +202,153 @@ void Historizer::dataChanged(const UA_NodeId* node_id, UA_UInt32 attribute_id,
   write(node_id, historize, value);
 }
 
-UA_StatusCode Historizer::registerNodeId(
-    UA_Server* server, UA_NodeId node_id, const UA_DataType* type) {
-  auto target = toSanitizedString(&node_id);
+UA_StatusCode Historizer::registerNodeId(UA_Server* server, UA_NodeId node_id,
+    const UA_DataType* type, bool sampled) {
+  return registerNodeIds(server, {NodeRegistration{node_id, type, sampled}});
+}
+
+UA_StatusCode Historizer::registerNodeIds(
+    UA_Server* server, const vector<NodeRegistration>& nodes) {
+  vector<string> targets;
+  targets.reserve(nodes.size());
+  for (const auto& node : nodes) {
+    targets.push_back(toSanitizedString(&node.node_id));
+  }
   try {
-    auto session = connect();
-    work transaction(session);
-    if (isHistorized(target)) {
-      updateHistorized(&transaction, target);
-    } else {
-      auto timestamp = getCurrentTimestamp();
-      transaction.exec(
-          fmt::format("INSERT INTO Historized_Nodes(Node_Id, Last_Updated)  "
-                      "VALUES('{}', '{}')",
-              target, timestamp));
+    withSession(pool_.get(),
+        [this, &nodes, &targets](PooledConnection& session) {
+          work transaction(*session);
+          vector<NodeStorage> storages;
+          storages.reserve(nodes.size());
+          for (size_t i = 0; i < nodes.size(); ++i) {
+            storages.push_back(
+                createNodeStorage(transaction, targets[i], nodes[i].type));
+          }
+          transaction.commit();
+          // other pooled connections prepare the statements on their first
+          // read
+          for (size_t i = 0; i < nodes.size(); ++i) {
+            prepareNodeStatements(&session,
+                addHistorizedNode(targets[i], storages[i]).statements);
+            if (retention_) {
+              retention_->track(
+                  targets[i], storages[i], isNumeric(nodes[i].type));
+            }
+          }
+        });
+  } catch (const exception& ex) {
+    logger_->critical(
+        "An unhandled exception occurred while trying to register {} nodes. "
+        "Exception: {}",
+        nodes.size(), ex.what());
+    return UA_STATUSCODE_BADUNEXPECTEDERROR;
+  }
+
+  auto result = UA_STATUSCODE_GOOD;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    if (!nodes[i].sampled) {
+      continue;
+    }
+    auto status = monitorNode(server, nodes[i], targets[i]);
+    if (result == UA_STATUSCODE_GOOD) {
+      result = status;
     }
+  }
+  return result;
+}
 
-    auto value_type = toSqlType(type);
-    transaction.exec(fmt::format("CREATE TABLE IF NOT EXISTS \"{}\"("
-                                 "Index BIGSERIAL PRIMARY KEY, "
+NodeStorage Historizer::createNodeStorage(pqxx::work& transaction,
+    const string& target, const UA_DataType* type) const {
+  auto value_type = toSqlType(type);
+  optional<string> history_table;
+  if (storage_.layout == StorageLayout::Partitioned) {
+    history_table = toHistoryTable(value_type);
+  }
+  auto upsert = "INSERT INTO Historized_Nodes(Node_Id, Last_Updated, "
+                "History_Table) VALUES($1, " +
+      fromUnixMicroseconds("$2") +
+      ", $3) ON CONFLICT (Node_Id) DO UPDATE SET "
+      "Last_Updated = EXCLUDED.Last_Updated, "
+      "History_Table = EXCLUDED.History_Table RETURNING Node_Key;";
+  auto node_key =
+      transaction
+          .exec(upsert,
+              params{target, toUnixMicroseconds(UA_DateTime_now()),
+                  history_table})
+          .one_field()
+          .as<int32_t>();
+
+  if (history_table.has_value()) {
+    transaction.exec(fmt::format("CREATE TABLE IF NOT EXISTS {}("
+                                 "Node_Key INTEGER NOT NULL, "
+                                 "Index BIGSERIAL, "
                                  "Server_Timestamp TIMESTAMP NOT NULL, "
                                  "Source_Timestamp TIMESTAMP NOT NULL, "
-                                 "Value {} NOT NULL);",
-        target, value_type)); // if table exists, check value data type
-    transaction.commit();
+                                 "Value {} NOT NULL"
+                                 ") PARTITION BY RANGE (Source_Timestamp);",
+        *history_table, value_type));
+    // covers all read statements, so range reads are index-only scans,
+    // variable length values are not included, since they could exceed
+    // the maximum index row size
+    bool fixed_size = value_type != "TEXT" && value_type != "BYTEA";
+    transaction.exec(fmt::format("CREATE INDEX IF NOT EXISTS {0}_Node_Time "
+                                 "ON {0} (Node_Key, Source_Timestamp, "
+                                 "Index) INCLUDE (Server_Timestamp{1});",
+        *history_table, fixed_size ? ", Value" : ""));
+    return NodeStorage{*history_table, node_key};
+  }
 
-    auto monitor_request = UA_MonitoredItemCreateRequest_default(node_id);
-    // NOLINTNEXTLINE(readability-magic-numbers)
-    monitor_request.requestedParameters.samplingInterval = 10000.0;
-    monitor_request.monitoringMode = UA_MONITORINGMODE_REPORTING;
-    auto* monitored_item_context = static_cast<void*>(this);
-    auto result = UA_Server_createDataChangeMonitoredItem(server,
-        UA_TIMESTAMPSTORETURN_BOTH, monitor_request, monitored_item_context,
-        &dataChangedCallback);
-    return result.statusCode;
-  } catch (const exception& ex) {
-    logger_->critical(
-        "An unhandled exception occurred while trying to register {} node. "
-        "Exception: {}",
-        target, ex.what());
-    return UA_STATUSCODE_BADUNEXPECTEDERROR;
+  transaction.exec(fmt::format("CREATE TABLE IF NOT EXISTS \"{}\"("
+                               "Index BIGSERIAL PRIMARY KEY, "
+                               "Server_Timestamp TIMESTAMP NOT NULL, "
+                               "Source_Timestamp TIMESTAMP NOT NULL, "
+                               "Value {} NOT NULL);",
+      target, value_type)); // if table exists, check value data type
+  // keyset pagination reads in (Source_Timestamp, Index) order
+  transaction.exec(fmt::format(
+      "DO $$ BEGIN IF NOT EXISTS (SELECT 1 FROM pg_indexes WHERE "
+      "tablename = {} AND indexdef LIKE '%(source_timestamp, index)') "
+      "THEN CREATE INDEX ON \"{}\" (Source_Timestamp, Index); END IF; "
+      "END $$;",
+      transaction.quote(target), target));
+  return NodeStorage{"\"" + target + "\"", nullopt};
+}
+
+UA_StatusCode Historizer::monitorNode(UA_Server* server,
+    const NodeRegistration& node, const string& target) {
+  const auto& parameters = monitoringParameters(target, node.type);
+  auto monitor_request = UA_MonitoredItemCreateRequest_default(node.node_id);
+  monitor_request.requestedParameters.samplingInterval =
+      parameters.sampling_interval;
+  monitor_request.requestedParameters.queueSize = parameters.queue_size;
+  monitor_request.requestedParameters.discardOldest =
+      parameters.discard_oldest;
+  monitor_request.monitoringMode = UA_MONITORINGMODE_REPORTING;
+  // the server copies the filter, so it can live on the stack
+  UA_DataChangeFilter filter;
+  UA_DataChangeFilter_init(&filter);
+  if (parameters.deadband_type != DeadbandType::None) {
+    filter.trigger = UA_DATACHANGETRIGGER_STATUSVALUE;
+    filter.deadbandType = parameters.deadband_type == DeadbandType::Absolute
+        ? UA_DEADBANDTYPE_ABSOLUTE
+        : UA_DEADBANDTYPE_PERCENT;
+    filter.deadbandValue = parameters.deadband_value;
+    UA_ExtensionObject_setValue(&monitor_request.requestedParameters.filter,
+        &filter, &UA_TYPES[UA_TYPES_DATACHANGEFILTER]);
+  }
+  auto* monitored_item_context = static_cast<void*>(this);
+  auto result = UA_Server_createDataChangeMonitoredItem(server,
+      UA_TIMESTAMPSTORETURN_BOTH, monitor_request, monitored_item_context,
+      &dataChangedCallback);
+  if (result.statusCode != UA_STATUSCODE_GOOD) {
+    logger_->error("Failed to monitor {} node for historization. Status: {}",
+        target, UA_StatusCode_name(result.statusCode));
   }
+  return result.statusCode;
 }
 
 void Historizer::write(const UA_NodeId* node_id, UA_Boolean historizing,
     const UA_DataValue* value) const {
-  auto target = toSanitizedString(node_id);
   if (!historizing) {
     logger_->info(
         "Node {} is not configured for historization ", toString(node_id));
@@ -229,90 +361,172 @@ void Historizer::write(const UA_NodeId* node_id, UA_Boolean historizing,
     return;
   }
 
-  try {
-    auto session = connect();
-    work transaction(session);
+  if (!isHistorizable(&(value->value))) {
+    logger_->error("Failed to historize Node {} value. Value type is not "
+                   "supported.",
+        toString(node_id));
+    return;
+  }
+
+  writer_->push(node_id, value);
+}
 
-    string source_time;
-    if (value->hasSourceTimestamp) {
-      source_time = toString(value->sourceTimestamp);
+WriterMetrics Historizer::writerMetrics() const { return writer_->metrics(); }
+
+Historizer::HistorizedNode Historizer::historizedNode(
+    const string& table) const {
+  {
+    shared_lock lock(nodes_mx_);
+    auto it = nodes_.find(table);
+    if (it != nodes_.end()) {
+      return it->second;
     }
-    string server_time;
-    if (value->hasServerTimestamp) {
-      server_time = toString(value->serverTimestamp);
+  }
+  return addHistorizedNode(table, lookupStorage(table));
+}
+
+Historizer::HistorizedNode Historizer::addHistorizedNode(
+    const string& table, const NodeStorage& storage) const {
+  unique_lock lock(nodes_mx_);
+  auto it = nodes_.find(table);
+  if (it != nodes_.end() && it->second.storage.relation == storage.relation &&
+      it->second.storage.node_key == storage.node_key) {
+    return it->second;
+  }
+  // connections, that already prepared the old statements, keep using them,
+  // so changed storages get new statement names
+  HistorizedNode node{storage,
+      registerNodeStatements(
+          pool_.get(), storage, "node_" + to_string(registered_nodes_))};
+  ++registered_nodes_;
+  nodes_.insert_or_assign(table, node);
+  return node;
+}
+
+NodeStorage Historizer::lookupStorage(const string& table) const {
+  if (storage_.layout == StorageLayout::TablePerNode) {
+    return NodeStorage{"\"" + table + "\"", nullopt};
+  }
+  auto rows = withSession(pool_.get(), [&table](PooledConnection& session) {
+    nontransaction transaction(*session);
+    return transaction.exec("SELECT Node_Key, History_Table FROM "
+                            "Historized_Nodes WHERE Node_ID = $1 AND "
+                            "History_Table IS NOT NULL;",
+        params{table});
+  });
+  if (rows.empty()) {
+    throw NoData();
+  }
+  return NodeStorage{rows[0]["History_Table"].as<string>(),
+      rows[0]["Node_Key"].as<int32_t>()};
+}
+
+const MonitoringParameters& Historizer::monitoringParameters(
+    const string& table, const UA_DataType* type) const {
+  for (size_t i = 0; i < monitoring_.rules.size(); ++i) {
+    const auto& rule = monitoring_.rules[i];
+    if ((rule.data_type.empty() || rule.data_type == type->typeName) &&
+        regex_match(table, monitoring_patterns_[i])) {
+      return rule.parameters;
     }
-    auto table = toSanitizedString(node_id);
-    params values{source_time, server_time};
-    addNodeValue(&values, &(value->value));
-
-    transaction.exec(
-        fmt::format(
-            "INSERT INTO \"{}\"(Source_Timestamp, Server_Timestamp, Value) "
-            "VALUES($1, $2, $3)",
-            table),
-        values);
-    updateHistorized(&transaction, target);
-    transaction.commit();
-  } catch (exception& ex) {
-    logger_->error("Failed to historize Node {} value due to an exception. "
-                   "Exception: {}",
-        toString(node_id), ex.what());
   }
+  return monitoring_.defaults;
 }
 
 HistoryResults Historizer::readHistory(
     const UA_ReadRawModifiedDetails* history_read_details,
     UA_UInt32 /*timeout_hint*/, UA_TimestampsToReturn timestamps_to_return,
     UA_NodeId node_id, const UA_ByteString* continuation_point_in,
-    [[maybe_unused]] UA_ByteString* continuation_point_out) const { // NOLINT
-
-  auto columns = setColumnNames(timestamps_to_return);
-  auto filters = setColumnFilters(history_read_details->returnBounds,
-      history_read_details->startTime, history_read_details->endTime,
-      continuation_point_in);
-
+    UA_ByteString* continuation_point_out) const {
+  auto start_time = history_read_details->startTime;
+  auto end_time = history_read_details->endTime;
   auto read_limit = history_read_details->numValuesPerNode;
-  string result_order = "ORDER BY Source_Timestamp ";
-  if (((history_read_details->startTime == 0) &&
-          ((read_limit != 0) && history_read_details->endTime != 0)) ||
-      (history_read_details->startTime > history_read_details->endTime)) {
-    // if start time was not specified (start time is equal to
-    // DateTime.MinValue), but end time AND read_limit is, OR end time is
-    // less than start time, than the historical values should be in reverse
-    // order (freshest values first, oldest ones last)
-    result_order += "DESC";
-  } else {
-    result_order += "ASC";
+  // if start time was not specified (start time is equal to
+  // DateTime.MinValue), but end time AND read_limit is, OR end time is
+  // less than start time, than the historical values should be in reverse
+  // order (freshest values first, oldest ones last)
+  bool reverse = ((start_time == 0) && ((read_limit != 0) && end_time != 0)) ||
+      ((end_time != 0) && (start_time > end_time));
+
+  // unspecified bounds are replaced with the earliest and latest UA_DateTime,
+  // so both bounds can always be passed as statement parameters
+  UA_DateTime lower = start_time;
+  UA_DateTime upper = end_time != 0 ? end_time : UA_INT64_MAX;
+  if (start_time != 0 && end_time != 0) {
+    lower = min(start_time, end_time);
+    upper = max(start_time, end_time);
+  }
+
+  optional<ContinuationPoint> position;
+  try {
+    position = readContinuationPoint(continuation_point_in);
+  } catch (const invalid_argument&) {
+    throw BadContinuationPoint();
+  }
+  // the first page starts before the first value in read order, rollup
+  // tiers expose all of their values with an Index of 0
+  auto cursor = position.value_or(reverse
+          ? ContinuationPoint{toUnixMicroseconds(upper), INT64_MAX}
+          : ContinuationPoint{toUnixMicroseconds(lower), INT64_MIN});
+
+  // one extra value is read to detect, if there is another page
+  optional<int64_t> limit; // if numValuesPerNode is zero, there is no limit
+  if (read_limit != 0) {
+    limit = static_cast<int64_t>(read_limit) + 1;
   }
 
-  auto session = connect();
-  work transaction(session);
   auto table = toSanitizedString(&node_id);
-  string query =
-      "SELECT " + columns + " FROM " + table + filters + result_order;
-
-  if (read_limit != 0) { // if numValuesPerNode is zero, there is no limit
-    query += " FETCH FIRST " + to_string(read_limit) + " ROWS ONLY";
-  }
-
-  auto rows = transaction.exec(query);
-  auto results = makeHistoryResults(rows, timestamps_to_return, type_map_);
-
-  if (read_limit != 0 && results.size() == read_limit) {
-    // check if there overrun
-    auto record_count =
-        transaction.exec("SELECT COUNT(*) FROM " + table + filters)
-            .expect_rows(1)
-            .at(0)
-            .at(0)
-            .as<long>();
-    if (record_count > read_limit) {
-      auto index = results.back().index;
-      // continuation_point_out is read by the Client, not the Server
-      continuation_point_out = makeContinuationPoint(index);
-    }
+  auto statements = historizedNode(table).statements;
+  // expired raw values are read from the finest rollup tier instead
+  optional<NodeStatements> rollup;
+  if (retention_) {
+    rollup = retention_->rollupForRaw(
+        table, toUnixMicroseconds(lower), toUnixMicroseconds(upper));
+  }
+  if (rollup.has_value()) {
+    statements = *rollup;
   }
-  return results;
+  params read_params{toUnixMicroseconds(lower), toUnixMicroseconds(upper),
+      static_cast<bool>(history_read_details->returnBounds),
+      cursor.source_micros, cursor.index, limit};
+  addRollupKey(&read_params, statements);
+  auto [results, next_page] = withSession(pool_.get(),
+      [&](PooledConnection& session) {
+        work transaction(*session);
+        auto rows = transaction.exec(
+            session.statement(
+                reverse ? statements.read_backward : statements.read_forward),
+            read_params);
+
+        optional<ContinuationPoint> next;
+        auto page_size = static_cast<size_t>(rows.size());
+        if (read_limit != 0 && page_size > read_limit) {
+          page_size = read_limit;
+          auto last = rows[static_cast<result::size_type>(page_size - 1)];
+          next = ContinuationPoint{last["Source_Micros"].as<int64_t>(),
+              last["Index"].as<int64_t>()};
+        }
+
+        HistoryResults page;
+        page.reserve(page_size);
+        for (size_t i = 0; i < page_size; ++i) {
+          appendHistoryResult(&page, rows[static_cast<result::size_type>(i)],
+              timestamps_to_return, type_map_);
+          if (rollup.has_value()) {
+            auto& value = page.back();
+            HistorianBits::setHistorianBits(
+                &value.status, HistorianBits::DataLocation::Calculated);
+            value.hasStatus = true;
+          }
+        }
+        return make_pair(move(page), next);
+      });
+
+  if (next_page.has_value()) {
+    *continuation_point_out = makeContinuationPoint(*next_page);
+  }
+  // structured bindings are not moved implicitly
+  return move(results);
 }
 
 void Historizer::readRaw(const UA_RequestHeader* request_header,
@@ -331,10 +545,14 @@ void Historizer::readRaw(const UA_RequestHeader* request_header,
             nodes_to_read[i].nodeId, &nodes_to_read[i].continuationPoint,
             &response->results[i].continuationPoint);
         response->results[i].statusCode =
-            expandHistoryResult(history_data[i], history_values);
+            expandHistoryResult(history_data[i], move(history_values));
+        selectHistoryIndexRange(
+            &response->results[i], history_data[i], nodes_to_read[i]);
       } catch (const BadContinuationPoint&) {
         response->results[i].statusCode =
             UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+      } catch (const NoData&) {
+        response->results[i].statusCode = UA_STATUSCODE_BADNODATA;
       } catch (const OutOfMemory&) {
         response->responseHeader.serviceResult = UA_STATUSCODE_BADOUTOFMEMORY;
       } catch (const runtime_error&) {
@@ -348,55 +566,84 @@ void Historizer::readRaw(const UA_RequestHeader* request_header,
    * setting any data*/
 }
 
-UA_StatusCode Historizer::readAndAppendHistory(
-    const UA_ReadAtTimeDetails* history_read_details,
-    UA_UInt32 /*timeout_hint*/, UA_TimestampsToReturn timestamps_to_return,
-    UA_NodeId node_id, const UA_ByteString* /*continuation_point_in*/,
-    [[maybe_unused]] UA_ByteString* continuation_point_out,
-    UA_HistoryData* history_data) const {
-
-  auto columns = setColumnNames(timestamps_to_return);
-  UA_StatusCode status = UA_STATUSCODE_GOOD;
+pair<UA_StatusCode, HistoryResults> Historizer::readAtTimes(
+    const NodeStatements& statements, const vector<int64_t>& requested,
+    UA_TimestampsToReturn timestamps_to_return) const {
   using namespace HistorianBits;
-  HistoryResults results;
-  for (size_t i = 0; i < history_read_details->reqTimesSize; ++i) {
-    auto timestamp = toString(history_read_details->reqTimes[i]);
-    auto session = connect();
-    work transaction(session);
-    auto table = toSanitizedString(&node_id);
+  auto read = [&](PooledConnection& session) {
+    work transaction(*session);
     /**
-     * @todo: use an async select request or a batch read, and check if
-     * timeout_hint elapsed, if it did set a continuation point
+     * @todo: check if timeout_hint elapsed, if it did set a continuation
+     * point
      */
-    auto rows =
-        transaction.exec(fmt::format("SELECT {} FROM {} WHERE Source_Timestamp "
-                                     "= {} ORDER BY Source_Timestamp ASC",
-            columns, table, timestamp));
-    if (rows.empty()) {
-      string nearest_query =
-          fmt::format("SELECT {} FROM {} WHERE Source_Timestamp $1 {} ORDER BY "
-                      "Source_Timestamp ASC LIMIT 1;",
-              columns, table, timestamp);
-      auto nearest_before = makeHistoryResult(
-          transaction.exec(nearest_query, params{"<"}).expect_rows(1).at(0),
-          timestamps_to_return, type_map_);
-      auto nearest_after = makeHistoryResult(
-          transaction.exec(nearest_query, params{">"}).expect_rows(1).at(0),
-          timestamps_to_return, type_map_);
+    params at_times_params{requested};
+    addRollupKey(&at_times_params, statements);
+    auto rows = transaction.exec(
+        session.statement(statements.at_times), at_times_params);
+
+    UA_StatusCode status = UA_STATUSCODE_GOOD;
+    HistoryResults results;
+    results.reserve(rows.size());
+    for (const auto& row : rows) {
+      if (!row["Index"].is_null()) {
+        appendHistoryResult(&results, row, timestamps_to_return, type_map_);
+        setHistorianBits(&status, DataLocation::Raw);
+        continue;
+      }
+
+      auto no_before = row["Before_Value"].is_null();
+      auto no_after = row["After_Value"].is_null();
+      if (no_before && no_after) {
+        throw NoData();
+      } else if (no_before || no_after) {
+        throw NoBoundData();
+      }
       // we do not check history_read_details->useSimpleBoundsflag,
       // because all values are Non-Bad for our case and thus
       // useSimpleBounds=False would not change the calculation
-      auto interpolated = interpolateValues(
-          history_read_details->reqTimes[i], nearest_before, nearest_after);
-      results.push_back(interpolated);
+      auto position = row["Ordinality"].as<size_t>() - 1;
+      auto before = toUaVariant(row["Before_Value"], type_map_);
+      auto after = toUaVariant(row["After_Value"], type_map_);
+      auto& interpolated = results.append();
+      try {
+        interpolated.value = interpolateValue(requested[position],
+            row["Before_Micros"].as<int64_t>(), before,
+            row["After_Micros"].as<int64_t>(), after);
+      } catch (...) {
+        UA_Variant_clear(&before);
+        UA_Variant_clear(&after);
+        throw;
+      }
+      UA_Variant_clear(&before);
+      UA_Variant_clear(&after);
+
+      interpolated.hasValue = true;
+      auto timestamp = toUaDateTime(requested[position]);
+      setTimestamps(
+          &interpolated, UA_TIMESTAMPSTORETURN_BOTH, timestamp, timestamp);
       setHistorianBits(&status, DataLocation::Interpolated);
-    } else {
-      auto raw = makeHistoryResults(rows, timestamps_to_return, type_map_);
-      results.insert(results.end(), raw.begin(), raw.end());
-      setHistorianBits(&status, DataLocation::Raw);
     }
+    return make_pair(status, move(results));
+  };
+  return withSession(pool_.get(), read);
+}
+
+UA_StatusCode Historizer::readAndAppendHistory(
+    const UA_ReadAtTimeDetails* history_read_details,
+    UA_UInt32 /*timeout_hint*/, UA_TimestampsToReturn timestamps_to_return,
+    UA_NodeId node_id, const UA_ByteString* /*continuation_point_in*/,
+    [[maybe_unused]] UA_ByteString* continuation_point_out,
+    UA_HistoryData* history_data) const {
+  vector<int64_t> requested;
+  requested.reserve(history_read_details->reqTimesSize);
+  for (size_t i = 0; i < history_read_details->reqTimesSize; ++i) {
+    requested.push_back(toUnixMicroseconds(history_read_details->reqTimes[i]));
   }
-  expandHistoryResult(history_data, results);
+
+  auto [status, results] =
+      readAtTimes(historizedNode(toSanitizedString(&node_id)).statements,
+          requested, timestamps_to_return);
+  expandHistoryResult(history_data, move(results));
   return status;
 }
 
@@ -417,6 +664,8 @@ void Historizer::readAtTime(const UA_RequestHeader* request_header,
                 request_header->timeoutHint, timestamps_to_return,
                 nodes_to_read[i].nodeId, &nodes_to_read[i].continuationPoint,
                 &response->results[i].continuationPoint, history_data[i]);
+        selectHistoryIndexRange(
+            &response->results[i], history_data[i], nodes_to_read[i]);
       } catch (const logic_error&) {
         // Target Node Id values can not be interpolated due to mismatching
         // data types or non aggregable data types (text, opaque values,
@@ -441,6 +690,162 @@ void Historizer::readAtTime(const UA_RequestHeader* request_header,
   }
 }
 
+UA_StatusCode Historizer::readAggregate(
+    const UA_ReadProcessedDetails* history_read_details, Aggregate aggregate,
+    UA_TimestampsToReturn timestamps_to_return, UA_NodeId node_id,
+    UA_HistoryData* history_data) const {
+  auto start_time = history_read_details->startTime;
+  auto end_time = history_read_details->endTime;
+  if (start_time == 0 || end_time == 0 || start_time == end_time) {
+    return UA_STATUSCODE_BADINVALIDTIMESTAMPARGUMENT;
+  }
+  auto lower = toUnixMicroseconds(min(start_time, end_time));
+  auto upper = toUnixMicroseconds(max(start_time, end_time));
+  // processing interval is given in milliseconds, zero means a single
+  // interval over the entire time range
+  auto width = upper - lower;
+  if (history_read_details->processingInterval > 0) {
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    width = llround(history_read_details->processingInterval * 1000);
+  }
+  if (width <= 0) {
+    return UA_STATUSCODE_BADINVALIDTIMESTAMPARGUMENT;
+  }
+  // checked before any interval is generated, a tiny processing interval
+  // over a long time range would exhaust the server or the database
+  auto intervals = static_cast<uint64_t>((upper - lower) / width +
+      ((upper - lower) % width != 0 ? 1 : 0));
+  if (intervals > processed_.max_intervals) {
+    logger_->warning("Rejected processed read of {} intervals for Node {}, "
+                     "at most {} intervals are allowed",
+        intervals, toString(&node_id), processed_.max_intervals);
+    return UA_STATUSCODE_BADTOOMANYOPERATIONS;
+  }
+
+  using namespace HistorianBits;
+  UA_StatusCode status = UA_STATUSCODE_GOOD;
+  HistoryResults results;
+  auto table = toSanitizedString(&node_id);
+  auto statements = historizedNode(table).statements;
+  if (aggregate == Aggregate::Interpolative) {
+    vector<int64_t> requested;
+    requested.reserve(static_cast<size_t>((upper - lower) / width) + 1);
+    for (auto bucket = lower; bucket < upper; bucket += width) {
+      requested.push_back(bucket);
+    }
+    tie(status, results) =
+        readAtTimes(statements, requested, timestamps_to_return);
+  } else {
+    // use the coarsest rollup tier, that can calculate the aggregate
+    if (retention_) {
+      auto rollup = retention_->rollupForAggregate(
+          table, aggregate, lower, upper, width);
+      if (rollup.has_value()) {
+        statements = *rollup;
+      }
+    }
+    const auto& statement =
+        statements.aggregates[static_cast<size_t>(aggregate)];
+    params aggregate_params{lower, upper, width};
+    addRollupKey(&aggregate_params, statements);
+    results = withSession(pool_.get(), [&](PooledConnection& session) {
+      work transaction(*session);
+      auto rows = transaction.exec(
+          session.statement(statement), aggregate_params);
+
+      HistoryResults calculated;
+      calculated.reserve(rows.size());
+      for (const auto& row : rows) {
+        auto bucket = row["Bucket_Micros"].as<int64_t>();
+        // the last interval is cut short by the end of the requested range
+        bool is_partial = bucket + width > upper;
+        auto& result = calculated.append();
+        if (aggregate == Aggregate::Count) {
+          // Count is defined as Int32 by OPC UA Part 13
+          auto count = static_cast<UA_Int32>(row["Value"].as<int64_t>());
+          UA_Variant_setScalarCopy(
+              &result.value, &count, &UA_TYPES[UA_TYPES_INT32]);
+          setHistorianBits(
+              &result.status, DataLocation::Calculated, is_partial);
+        } else if (row["Value"].is_null()) {
+          result.status = UA_STATUSCODE_BADNODATA;
+        } else {
+          result.value = toUaVariant(row["Value"], type_map_);
+          setHistorianBits(
+              &result.status, DataLocation::Calculated, is_partial);
+        }
+        result.hasValue = !UA_Variant_isEmpty(&result.value);
+        result.hasStatus = result.status != UA_STATUSCODE_GOOD;
+
+        auto timestamp = toUaDateTime(bucket);
+        setTimestamps(&result, timestamps_to_return, timestamp, timestamp);
+      }
+      return calculated;
+    });
+    setHistorianBits(&status, DataLocation::Calculated,
+        (upper - lower) % width != 0);
+  }
+
+  if (start_time > end_time) {
+    // end time before start time requests the intervals in reverse order
+    results.reverse();
+  }
+  auto append_status = expandHistoryResult(history_data, move(results));
+  return append_status == UA_STATUSCODE_GOOD ? status : append_status;
+}
+
+void Historizer::readProcessed(const UA_RequestHeader* /*request_header*/,
+    const UA_ReadProcessedDetails* history_read_details,
+    UA_TimestampsToReturn timestamps_to_return,
+    UA_Boolean release_continuation_points, size_t nodes_to_read_size,
+    const UA_HistoryReadValueId* nodes_to_read,
+    UA_HistoryReadResponse* response,
+    UA_HistoryData* const* const history_data) const {
+  if (history_read_details->aggregateTypeSize != nodes_to_read_size) {
+    response->responseHeader.serviceResult =
+        UA_STATUSCODE_BADAGGREGATELISTMISMATCH;
+    return;
+  }
+  response->responseHeader.serviceResult = UA_STATUSCODE_GOOD;
+  if (!release_continuation_points) {
+    for (size_t i = 0; i < nodes_to_read_size; ++i) {
+      auto aggregate = toAggregate(history_read_details->aggregateType[i]);
+      if (!aggregate.has_value()) {
+        response->results[i].statusCode =
+            UA_STATUSCODE_BADAGGREGATENOTSUPPORTED;
+        continue;
+      }
+      try {
+        response->results[i].statusCode =
+            readAggregate(history_read_details, *aggregate,
+                timestamps_to_return, nodes_to_read[i].nodeId, history_data[i]);
+      } catch (const syntax_error&) {
+        // aggregate statement can not be prepared for the value type of this
+        // node, for example there is no AVG() or FLOAT8 cast for BOOL values
+        response->results[i].statusCode =
+            UA_STATUSCODE_BADAGGREGATEINVALIDINPUTS;
+      } catch (const data_exception&) {
+        response->results[i].statusCode =
+            UA_STATUSCODE_BADAGGREGATEINVALIDINPUTS;
+      } catch (const logic_error&) {
+        // values can not be interpolated due to mismatching or non
+        // aggregable data types
+        response->results[i].statusCode =
+            UA_STATUSCODE_BADAGGREGATEINVALIDINPUTS;
+      } catch (const NoBoundData&) {
+        response->results[i].statusCode = UA_STATUSCODE_BADBOUNDNOTFOUND;
+      } catch (const NoData&) {
+        response->results[i].statusCode = UA_STATUSCODE_BADNODATA;
+      } catch (const OutOfMemory&) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADOUTOFMEMORY;
+      } catch (const runtime_error&) {
+        // handle unexpected read exceptions here
+        response->results[i].statusCode = UA_STATUSCODE_BADUNEXPECTEDERROR;
+      }
+    }
+  }
+}
+
 UA_HistoryDatabase createDatabaseStruct(const HistorizerPtr& historizer) {
   UA_HistoryDatabase database;
   memset(&database, 0, sizeof(UA_HistoryDatabase));
@@ -452,7 +857,7 @@ UA_HistoryDatabase createDatabaseStruct(const HistorizerPtr& historizer) {
   database.readRaw = &readRawCallback;
   database.readModified = nullptr;
   database.readEvent = nullptr;
-  database.readProcessed = nullptr;
+  database.readProcessed = &readProcessedCallback;
   database.readAtTime = &readAtTimeCallback;
   database.updateData = nullptr;
   database.deleteRawModified = nullptr;
@@ -1,20 +1,24 @@
 #include "HistorizerUtils.hpp"
 #include "Exceptions.hpp"
 #include "StringConverter.hpp"
-#include "UaVariantOperators.hpp"
+#include "TypeRegistry.hpp"
 
 #include <date/date.h>
 #include <fmt/format.h>
+#include <open62541/nodeids.h>
 
+#include <cctype>
 #include <chrono>
-#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <type_traits>
 
 namespace open62541 {
 using namespace std;
 using namespace pqxx;
 
-void createDomainRestrictions(connection session) {
-  work transaction(session);
+void createDomainRestrictions(work* transaction) {
   // NOLINTBEGIN(readability-magic-numbers)
   unordered_map<string, size_t> domains{
       // clang-format off
@@ -30,19 +34,19 @@ void createDomainRestrictions(connection session) {
   for (const auto& [type_name, limit] : domains) {
     auto domain = fmt::format(
         "{} AS INTEGER CHECK (VALUE >= 0 AND VALUE < {})", type_name, limit);
-    transaction.exec(fmt::format(create, type_name, domain));
+    transaction->exec(fmt::format(create, type_name, domain));
   }
   // int8 requires different limits, hence we create it separately
-  transaction.exec(fmt::format(create, "OPCUA_TINYINT",
+  transaction->exec(fmt::format(create, "OPCUA_TINYINT",
       "OPCUA_TINYINT AS INTEGER CHECK (VALUE >= -128 AND VALUE < 128)"));
 
   // uint64 does not fit into integer, hence we use numeric
-  transaction.exec(fmt::format(create, "OPCUA_BIGUINT",
+  transaction->exec(fmt::format(create, "OPCUA_BIGUINT",
       "OPCUA_BIGUINT AS NUMERIC CHECK (VALUE >= 0 AND VALUE "
       "< 18446744073709551616)"));
 }
 
-TypeMap queryTypeOIDs(connection session) {
+TypeMap queryTypeOIDs(work* transaction) {
   unordered_map<string, size_t> typenames{// clang-format off
       {"BOOL", UA_DataTypeKind::UA_DATATYPEKIND_BOOLEAN},
       {"OPCUA_TINYUINT", UA_DataTypeKind::UA_DATATYPEKIND_BYTE},
@@ -61,10 +65,9 @@ TypeMap queryTypeOIDs(connection session) {
       {"TEXT", UA_DataTypeKind::UA_DATATYPEKIND_STRING}
   }; // clang-format on
   TypeMap result;
-  work transaction(session);
   for (const auto& [type_name, type_code] : typenames) {
     auto oid = transaction
-                   .exec(fmt::format(
+                   ->exec(fmt::format(
                        "SELECT oid FROM pg_type WHERE typname = LOWER('{}');",
                        type_name))
                    .expect_rows(1)
@@ -77,165 +80,451 @@ TypeMap queryTypeOIDs(connection session) {
   return result;
 }
 
-string getCurrentTimestamp() {
-  auto timestamp = chrono::system_clock::now();
-  return date::format("%F %T", timestamp);
+int64_t toUnixMicroseconds(UA_DateTime timestamp) {
+  return (timestamp - UA_DATETIME_UNIX_EPOCH) / UA_DATETIME_USEC;
 }
 
-string toSanitizedString(const UA_NodeId* node_id) {
-  auto result = toString(node_id);
-  // strip "ns=1;s=" prefix, it's 7 chars long
-  return result.substr(7); // NOLINT(readability-magic-numbers)
+UA_DateTime toUaDateTime(int64_t unix_microseconds) {
+  return unix_microseconds * UA_DATETIME_USEC + UA_DATETIME_UNIX_EPOCH;
 }
 
-void addNodeValue(params* values, const UA_Variant* variant) {
-  switch (variant->type->typeKind) {
-  case UA_DataTypeKind::UA_DATATYPEKIND_BOOLEAN: {
-    auto value = *((bool*)(variant->data));
-    values->append(value);
-    break;
-  }
-  // NOLINTNEXTLINE(bugprone-branch-clone)
-  case UA_DataTypeKind::UA_DATATYPEKIND_SBYTE: {
-    [[fallthrough]]; // pqxx does not allow signed char as a parameter
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_BYTE: {
-    [[fallthrough]]; // pqxx does not allow unsigned char as a parameter
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT16: {
-    auto value = *((UA_UInt16*)(variant->data));
-    values->append(value);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT16: {
-    auto value = *((UA_Int16*)(variant->data));
-    values->append(value);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT32: {
-    auto value = *((UA_UInt32*)(variant->data));
-    values->append(value);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT32: {
-    auto value = *((UA_Int32*)(variant->data));
-    values->append(value);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT64: {
-    auto value = *((UA_UInt64*)(variant->data));
-    values->append(value);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT64: {
-    auto value = *((UA_Int64*)(variant->data));
-    values->append(value);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_STATUSCODE: {
-    auto value = *((UA_StatusCode*)(variant->data));
-    values->append(value);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_FLOAT: {
-    auto value = *((UA_Float*)(variant->data));
-    values->append(value);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_DOUBLE: {
-    auto value = *((UA_Double*)(variant->data));
-    values->append(value);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_DATETIME: {
-    auto value = toString(*((UA_DateTime*)(variant->data)));
-    values->append(value);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_BYTESTRING: {
-    auto* byte_string = (UA_ByteString*)(variant->data);
-    values->append(binary_cast(byte_string->data, byte_string->length));
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_STRING: {
-    auto* ua_string = (UA_String*)(variant->data);
-    auto value = string((char*)ua_string->data, ua_string->length);
-    values->append(value);
-    break;
+string fromUnixMicroseconds(const string& parameter) {
+  return "('epoch'::TIMESTAMP + " + parameter +
+      "::BIGINT * INTERVAL '1 microsecond')";
+}
+
+string toUnixMicrosecondsColumn(const string& column) {
+  return "(EXTRACT(EPOCH FROM " + column + ") * 1000000)::BIGINT";
+}
+
+optional<Aggregate> toAggregate(const UA_NodeId& aggregate_type) {
+  if (aggregate_type.namespaceIndex != 0 ||
+      aggregate_type.identifierType != UA_NODEIDTYPE_NUMERIC) {
+    return nullopt;
+  }
+  switch (aggregate_type.identifier.numeric) {
+  case UA_NS0ID_AGGREGATEFUNCTION_AVERAGE: {
+    return Aggregate::Average;
+  }
+  case UA_NS0ID_AGGREGATEFUNCTION_MINIMUM: {
+    return Aggregate::Minimum;
+  }
+  case UA_NS0ID_AGGREGATEFUNCTION_MAXIMUM: {
+    return Aggregate::Maximum;
+  }
+  case UA_NS0ID_AGGREGATEFUNCTION_COUNT: {
+    return Aggregate::Count;
+  }
+  case UA_NS0ID_AGGREGATEFUNCTION_START: {
+    return Aggregate::Start;
+  }
+  case UA_NS0ID_AGGREGATEFUNCTION_END: {
+    return Aggregate::End;
+  }
+  case UA_NS0ID_AGGREGATEFUNCTION_DELTA: {
+    return Aggregate::Delta;
+  }
+  case UA_NS0ID_AGGREGATEFUNCTION_TIMEAVERAGE: {
+    return Aggregate::TimeAverage;
+  }
+  case UA_NS0ID_AGGREGATEFUNCTION_INTERPOLATIVE: {
+    return Aggregate::Interpolative;
   }
   default: {
-    string error_msg = "Unhandled UA_Variant type detected: " +
-        string(variant->type->typeName);
-    throw logic_error(error_msg);
+    return nullopt;
   }
   }
 }
 
-string setColumnNames(UA_TimestampsToReturn timestamps_to_return) {
-  string result = "Index, Value";
-  if (timestamps_to_return != UA_TIMESTAMPSTORETURN_NEITHER) {
-    if (timestamps_to_return == UA_TIMESTAMPSTORETURN_SOURCE ||
-        timestamps_to_return == UA_TIMESTAMPSTORETURN_BOTH) {
-      result += ", Source_Timestamp";
-    }
-    if (timestamps_to_return == UA_TIMESTAMPSTORETURN_SERVER ||
-        timestamps_to_return == UA_TIMESTAMPSTORETURN_BOTH) {
-      result += ", Server_Timestamp";
+string selectFrom(const NodeStorage& storage) {
+  string result = storage.relation + " WHERE ";
+  if (storage.node_key.has_value()) {
+    result += "Node_Key = " + to_string(*storage.node_key) + " AND ";
+  }
+  return result;
+}
+
+string toEpochSeconds(const string& column) {
+  return "EXTRACT(EPOCH FROM " + column + ")::FLOAT8";
+}
+
+string makeBucketsQuery(const NodeStorage& storage, const string& value) {
+  auto lower = fromUnixMicroseconds("$1");
+  auto upper = fromUnixMicroseconds("$2");
+  auto width = "($3::BIGINT * INTERVAL '1 microsecond')";
+  return fmt::format(
+      "WITH Buckets AS (SELECT generate_series({0}, {1} - INTERVAL '1 "
+      "microsecond', {2}) AS Bucket_Start), "
+      "Samples AS (SELECT date_bin({2}, Source_Timestamp, {0}) AS "
+      "Bucket_Start, Source_Timestamp, Value FROM {3}Source_Timestamp >= {0} "
+      "AND Source_Timestamp < {1}) "
+      "SELECT {4} AS Bucket_Micros, COUNT(Samples.Value) AS Sample_Count, {5} "
+      "AS Value FROM Buckets LEFT JOIN Samples ON Samples.Bucket_Start = "
+      "Buckets.Bucket_Start GROUP BY Buckets.Bucket_Start ORDER BY "
+      "Buckets.Bucket_Start ASC;",
+      lower, upper, width, selectFrom(storage),
+      toUnixMicrosecondsColumn("Buckets.Bucket_Start"), value);
+}
+
+/**
+ * @brief Time weighted average, as defined in OPC UA Part 13 section 5.4.3.3
+ * with sloped interpolation. The values are linearly interpolated between
+ * samples, including the samples right before and after the requested range,
+ * and the area below them is divided by the duration covered by data
+ */
+string makeTimeAverageQuery(const NodeStorage& storage) {
+  auto lower = fromUnixMicroseconds("$1");
+  auto upper = fromUnixMicroseconds("$2");
+  auto width = "($3::BIGINT * INTERVAL '1 microsecond')";
+  auto value_at = [](const string& time) {
+    return fmt::format(
+        "(V0 + (V1 - V0) * ({} - T0) / NULLIF(T1 - T0, 0))", time);
+  };
+  return fmt::format(
+      "WITH Buckets AS (SELECT B AS Bucket_Start, LEAST(B + {2}, {1}) AS "
+      "Bucket_End FROM generate_series({0}, {1} - INTERVAL '1 microsecond', "
+      "{2}) AS B), "
+      "Points AS ((SELECT Source_Timestamp AS Ts, Value::FLOAT8 AS V FROM "
+      "{3}Source_Timestamp < {0} ORDER BY Source_Timestamp DESC LIMIT 1) "
+      "UNION ALL (SELECT Source_Timestamp, Value::FLOAT8 FROM {3}"
+      "Source_Timestamp >= {0} AND Source_Timestamp < {1}) UNION ALL (SELECT "
+      "Source_Timestamp, Value::FLOAT8 FROM {3}Source_Timestamp >= {1} ORDER "
+      "BY Source_Timestamp ASC LIMIT 1)), "
+      "Segments AS (SELECT {4} AS T0, V AS V0, LEAD({4}) OVER W AS T1, "
+      "LEAD(V) OVER W AS V1 FROM Points WINDOW W AS (ORDER BY Ts)), "
+      "Clipped AS (SELECT Bucket_Start, GREATEST(T0, {5}) AS C0, LEAST(T1, "
+      "{6}) AS C1, T0, V0, T1, V1 FROM Buckets JOIN Segments ON T1 IS NOT "
+      "NULL AND T0 < {6} AND T1 > {5}) "
+      "SELECT {7} AS Bucket_Micros, COUNT(Clipped.T0) AS Sample_Count, "
+      "SUM((C1 - C0) * ({8} + {9}) / 2) / NULLIF(SUM(C1 - C0), 0) AS Value "
+      "FROM Buckets LEFT JOIN Clipped ON Clipped.Bucket_Start = "
+      "Buckets.Bucket_Start GROUP BY Buckets.Bucket_Start ORDER BY "
+      "Buckets.Bucket_Start ASC;",
+      lower, upper, width, selectFrom(storage), toEpochSeconds("Ts"),
+      toEpochSeconds("Bucket_Start"), toEpochSeconds("Bucket_End"),
+      toUnixMicrosecondsColumn("Buckets.Bucket_Start"), value_at("C0"),
+      value_at("C1"));
+}
+
+string makeRollupBucketsQuery(const string& filter, const string& value) {
+  auto lower = fromUnixMicroseconds("$1");
+  auto upper = fromUnixMicroseconds("$2");
+  auto width = "($3::BIGINT * INTERVAL '1 microsecond')";
+  return fmt::format(
+      "WITH Buckets AS (SELECT generate_series({0}, {1} - INTERVAL '1 "
+      "microsecond', {2}) AS Bucket_Start), "
+      "Samples AS (SELECT date_bin({2}, Bucket_Start, {0}) AS Bucket_Start, "
+      "Sample_Count, Minimum, Maximum, Average FROM {3} WHERE {4} AND "
+      "Bucket_Start >= {0} AND Bucket_Start < {1}) "
+      "SELECT {5} AS Bucket_Micros, COALESCE(SUM(Samples.Sample_Count), "
+      "0)::BIGINT AS Sample_Count, {6} AS Value FROM Buckets LEFT JOIN Samples "
+      "ON Samples.Bucket_Start = Buckets.Bucket_Start GROUP BY "
+      "Buckets.Bucket_Start ORDER BY Buckets.Bucket_Start ASC;",
+      lower, upper, width, ROLLUP_TABLE, filter,
+      toUnixMicrosecondsColumn("Buckets.Bucket_Start"), value);
+}
+
+// read_forward and read_backward parameters
+constexpr size_t READ_PARAMETERS = 6;
+// at_times parameters
+constexpr size_t AT_TIMES_PARAMETERS = 1;
+// aggregate statement parameters
+constexpr size_t AGGREGATE_PARAMETERS = 3;
+
+/**
+ * @brief Rollup tier filter, that takes the Node_ID and Interval_Seconds as
+ * the two parameters after the given number of statement parameters
+ *
+ */
+string rollupFilter(size_t parameters) {
+  return fmt::format("Node_ID = ${} AND Interval_Seconds = ${}::INTEGER",
+      parameters + 1, parameters + 2);
+}
+
+string toHistoryTable(const string& sql_type) {
+  string result = "History_";
+  for (auto character : sql_type) {
+    if (isalnum(static_cast<unsigned char>(character)) != 0) {
+      result += character;
+    } else if (result.back() != '_') {
+      result += '_';
     }
   }
+  // TIMESTAMP(6) would otherwise end with an underscore
+  if (result.back() == '_') {
+    result.pop_back();
+  }
+  return result;
+}
+
+/**
+ * @brief Exposes the averages of a rollup tier as the Index, Value,
+ * Source_Timestamp and Server_Timestamp columns, so the raw read statements
+ * can be used on the rollup tier
+ *
+ */
+NodeStorage rollupStorage(size_t parameters) {
+  return NodeStorage{
+      fmt::format("(SELECT 0::BIGINT AS Index, Average AS Value, Bucket_Start "
+                  "AS Source_Timestamp, Bucket_Start AS Server_Timestamp FROM "
+                  "{} WHERE {}) AS Rollup",
+          ROLLUP_TABLE, rollupFilter(parameters)),
+      nullopt};
+}
+
+/**
+ * @brief Statement names of the given prefix, rollup statements only
+ * calculate a subset of the aggregates, so the aggregate names are set by
+ * the caller
+ *
+ */
+NodeStatements makeStatementNames(const string& prefix) {
+  auto name = [&prefix](const string& statement) {
+    return prefix + "_" + statement;
+  };
+  return NodeStatements{.read_forward = name("read_forward"),
+      .read_backward = name("read_backward"),
+      .at_times = name("at_times"),
+      .aggregates = {},
+      .rollup = nullopt};
+}
+
+/**
+ * @brief Registers the read_forward, read_backward and at_times statements
+ *
+ * @param storage - returns the storage for a statement with the given number
+ * of parameters
+ */
+void registerReadStatements(ConnectionPool* pool,
+    const NodeStatements& statements,
+    const function<NodeStorage(size_t)>& storage) {
+  auto from = selectFrom(storage(READ_PARAMETERS));
+  // timestamps are returned as integers, so rows decode without parsing
+  auto select = fmt::format("SELECT Index, Value, {} AS Source_Micros, {} AS "
+                            "Server_Micros FROM {}",
+      toUnixMicrosecondsColumn("Source_Timestamp"),
+      toUnixMicrosecondsColumn("Server_Timestamp"), from);
+  auto lower = fromUnixMicroseconds("$1");
+  auto upper = fromUnixMicroseconds("$2");
+  // both bounds are always set, so the range condition can use an index,
+  // exclusive bounds are filtered out afterwards
+  auto filters = fmt::format(
+      "Source_Timestamp >= {0} AND Source_Timestamp <= {1} AND ($3 OR "
+      "(Source_Timestamp > {0} AND Source_Timestamp < {1})) ",
+      lower, upper);
+  // pages continue after the (Source_Timestamp, Index) key of the last value
+  // of the previous page
+  auto cursor = fromUnixMicroseconds("$4");
+  pool->registerStatement(statements.read_forward,
+      fmt::format("{}{}AND (Source_Timestamp, Index) > ({}, $5) ORDER BY "
+                  "Source_Timestamp ASC, Index ASC LIMIT $6;",
+          select, filters, cursor));
+  pool->registerStatement(statements.read_backward,
+      fmt::format("{}{}AND (Source_Timestamp, Index) < ({}, $5) ORDER BY "
+                  "Source_Timestamp DESC, Index DESC LIMIT $6;",
+          select, filters, cursor));
+
+  // resolves all requested timestamps at once, bounding values are only
+  // looked up for timestamps without an exact match
+  auto requested = fromUnixMicroseconds("Requested.Micros");
+  pool->registerStatement(statements.at_times,
+      fmt::format(
+          "SELECT Requested.Ordinality, Exact_Match.Index, Exact_Match.Value, "
+          "Exact_Match.Source_Micros, Exact_Match.Server_Micros, "
+          "Bound_Before.Value AS Before_Value, {2} AS Before_Micros, "
+          "Bound_After.Value AS After_Value, {3} AS After_Micros "
+          "FROM unnest($1::BIGINT[]) WITH ORDINALITY AS "
+          "Requested(Micros, Ordinality) "
+          "LEFT JOIN LATERAL (SELECT Index, Value, {4} AS Source_Micros, "
+          "{5} AS Server_Micros FROM {0}Source_Timestamp = {1}) AS "
+          "Exact_Match ON TRUE "
+          "LEFT JOIN LATERAL (SELECT Value, Source_Timestamp FROM {0}"
+          "Exact_Match.Index IS NULL AND Source_Timestamp < {1} ORDER BY "
+          "Source_Timestamp DESC LIMIT 1) AS Bound_Before ON TRUE "
+          "LEFT JOIN LATERAL (SELECT Value, Source_Timestamp FROM {0}"
+          "Exact_Match.Index IS NULL AND Source_Timestamp > {1} ORDER BY "
+          "Source_Timestamp ASC LIMIT 1) AS Bound_After ON TRUE "
+          "ORDER BY Requested.Ordinality, Exact_Match.Index;",
+          selectFrom(storage(AT_TIMES_PARAMETERS)), requested,
+          toUnixMicrosecondsColumn("Bound_Before.Source_Timestamp"),
+          toUnixMicrosecondsColumn("Bound_After.Source_Timestamp"),
+          toUnixMicrosecondsColumn("Source_Timestamp"),
+          toUnixMicrosecondsColumn("Server_Timestamp")));
+}
+
+NodeStatements registerNodeStatements(ConnectionPool* pool,
+    const NodeStorage& storage, const string& prefix) {
+  auto name = [&prefix](const string& statement) {
+    return prefix + "_" + statement;
+  };
+  auto result = makeStatementNames(prefix);
+  result.aggregates = {name("average"), name("minimum"), name("maximum"),
+      name("count"), name("start"), name("end"), name("delta"),
+      name("time_average")};
+  registerReadStatements(
+      pool, result, [&storage](size_t /*parameters*/) { return storage; });
+
+  auto aggregate = [&result](Aggregate type) -> const string& {
+    return result.aggregates[static_cast<size_t>(type)];
+  };
+  pool->registerStatement(aggregate(Aggregate::Average),
+      makeBucketsQuery(storage, "AVG(Samples.Value::FLOAT8)"));
+  pool->registerStatement(aggregate(Aggregate::Minimum),
+      makeBucketsQuery(storage, "MIN(Samples.Value)"));
+  pool->registerStatement(aggregate(Aggregate::Maximum),
+      makeBucketsQuery(storage, "MAX(Samples.Value)"));
+  pool->registerStatement(aggregate(Aggregate::Count),
+      makeBucketsQuery(storage, "COUNT(Samples.Value)"));
+  pool->registerStatement(aggregate(Aggregate::Start),
+      makeBucketsQuery(storage,
+          "(ARRAY_AGG(Samples.Value ORDER BY Samples.Source_Timestamp "
+          "ASC))[1]"));
+  pool->registerStatement(aggregate(Aggregate::End),
+      makeBucketsQuery(storage,
+          "(ARRAY_AGG(Samples.Value ORDER BY Samples.Source_Timestamp "
+          "DESC))[1]"));
+  pool->registerStatement(aggregate(Aggregate::Delta),
+      makeBucketsQuery(storage,
+          "(ARRAY_AGG(Samples.Value::FLOAT8 ORDER BY Samples.Source_Timestamp "
+          "DESC))[1] - (ARRAY_AGG(Samples.Value::FLOAT8 ORDER BY "
+          "Samples.Source_Timestamp ASC))[1]"));
+  pool->registerStatement(
+      aggregate(Aggregate::TimeAverage), makeTimeAverageQuery(storage));
+  return result;
+}
+
+NodeStatements registerRollupStatements(
+    ConnectionPool* pool, const string& prefix) {
+  auto result = makeStatementNames(prefix);
+  registerReadStatements(pool, result, rollupStorage);
+  auto filter = rollupFilter(AGGREGATE_PARAMETERS);
+  auto aggregate = [&result, &prefix](Aggregate type, const string& name) {
+    auto& statement = result.aggregates[static_cast<size_t>(type)];
+    statement = prefix + "_" + name;
+    return statement;
+  };
+  // the average of a rollup interval is weighted by its sample count
+  pool->registerStatement(aggregate(Aggregate::Average, "average"),
+      makeRollupBucketsQuery(filter,
+          "SUM(Samples.Average * Samples.Sample_Count) / "
+          "NULLIF(SUM(Samples.Sample_Count), 0)"));
+  pool->registerStatement(aggregate(Aggregate::Minimum, "minimum"),
+      makeRollupBucketsQuery(filter, "MIN(Samples.Minimum)"));
+  pool->registerStatement(aggregate(Aggregate::Maximum, "maximum"),
+      makeRollupBucketsQuery(filter, "MAX(Samples.Maximum)"));
+  pool->registerStatement(aggregate(Aggregate::Count, "count"),
+      makeRollupBucketsQuery(
+          filter, "COALESCE(SUM(Samples.Sample_Count), 0)::BIGINT"));
   return result;
 }
 
-string setColumnFilters(
-    UA_Boolean include_bounds, UA_DateTime start_time, UA_DateTime end_time) {
-  UA_DateTime start, end;
-  if (start_time < end_time) {
-    start = start_time;
-    end = end_time;
-  } else { // set reverse order filters
-    start = end_time;
-    end = start_time;
+void addRollupKey(params* values, const NodeStatements& statements) {
+  if (statements.rollup.has_value()) {
+    values->append(statements.rollup->node_id);
+    values->append(statements.rollup->interval_seconds);
   }
+}
 
-  string lower_filter = ">";
-  string upper_filter = "<";
-  if (include_bounds) {
-    lower_filter += "=";
-    upper_filter += "=";
+void prepareNodeStatements(
+    PooledConnection* session, const NodeStatements& statements) {
+  for (const auto* name : {&statements.read_forward,
+           &statements.read_backward, &statements.at_times}) {
+    session->statement(*name);
   }
+}
 
-  string result = "WHERE";
-  if (start > 0) {
-    result += " Source_Timestamp " + lower_filter + toString(start);
-    if (end > 0) {
-      result += " AND ";
-    }
+string toSanitizedString(const UA_NodeId* node_id) {
+  auto result = toString(node_id);
+  // strip "ns=1;s=" prefix, it's 7 chars long
+  return result.substr(7); // NOLINT(readability-magic-numbers)
+}
+
+/**
+ * @brief Value of the given variant as a type, that pqxx can pass as a
+ * parameter or stream field
+ *
+ */
+template <typename Type> auto toSqlField(const UA_Variant& variant) {
+  const auto& value = Type::value(variant);
+  if constexpr (Type::kind == UA_DATATYPEKIND_DATETIME) {
+    return toString(value);
+  } else if constexpr (Type::kind == UA_DATATYPEKIND_BYTESTRING) {
+    return binary_cast(value.data, value.length);
+  } else if constexpr (Type::kind == UA_DATATYPEKIND_STRING) {
+    return string_view((char*)value.data, value.length);
+  } else if constexpr (sizeof(typename Type::type) == 1 &&
+      Type::kind != UA_DATATYPEKIND_BOOLEAN) {
+    // pqxx does not allow signed or unsigned char as a parameter
+    return static_cast<int16_t>(value);
+  } else {
+    return value;
   }
-  if (end > 0) {
-    result += " Source_Timestamp " + upper_filter + toString(end);
+}
+
+template <typename Type> struct AppendValue {
+  static void apply(params* values, const UA_Variant& variant) {
+    if constexpr (Type::kind == UA_DATATYPEKIND_STRING) {
+      // params keep string views, copy the value, so it outlives the variant
+      values->append(string(toSqlField<Type>(variant)));
+    } else {
+      values->append(toSqlField<Type>(variant));
+    }
   }
+};
+
+constexpr auto APPEND_VALUE =
+    makeDispatchTable<void(params*, const UA_Variant&), AppendValue>(
+        ScalarTypes{});
 
-  return result != "WHERE" ? result : "";
+void addNodeValue(params* values, const UA_Variant* variant) {
+  auto* append = dispatch(APPEND_VALUE, variant->type);
+  if (append == nullptr) {
+    string error_msg = "Unhandled UA_Variant type detected: " +
+        string(variant->type->typeName);
+    throw logic_error(error_msg);
+  }
+  append(values, *variant);
 }
 
-string setColumnFilters(UA_Boolean include_bounds, UA_DateTime start_time,
-    UA_DateTime end_time, const UA_ByteString* continuation_point) {
-  auto result = setColumnFilters(include_bounds, start_time, end_time);
+bool isHistorizable(const UA_Variant* variant) {
+  if (UA_Variant_isEmpty(variant) || !UA_Variant_isScalar(variant)) {
+    return false;
+  }
+  return typeInfo(variant->type).registered;
+}
 
-  if (continuation_point != nullptr) {
-    auto continuation_index =
-        string((char*)continuation_point->data, continuation_point->length);
-    if (!continuation_index.empty()) {
-      if (!result.empty()) {
-        result += " AND";
-      } else {
-        result = "WHERE";
-      }
-      result += "Index > " + continuation_index;
+bool isNumeric(const UA_DataType* type) { return typeInfo(type).numeric; }
+
+template <typename Type> struct StreamValue {
+  static void apply(stream_to* stream, optional<int32_t> node_key,
+      const string& source_time, const string& server_time,
+      const UA_Variant& variant) {
+    auto field = toSqlField<Type>(variant);
+    if (node_key.has_value()) {
+      stream->write_values(*node_key, source_time, server_time, field);
+    } else {
+      stream->write_values(source_time, server_time, field);
     }
   }
+};
 
-  return result;
+using StreamOperation = void(stream_to*, optional<int32_t>, const string&,
+    const string&, const UA_Variant&);
+
+constexpr auto STREAM_VALUE =
+    makeDispatchTable<StreamOperation, StreamValue>(ScalarTypes{});
+
+void streamNodeValue(
+    stream_to* stream, const UA_DataValue* value, optional<int32_t> node_key) {
+  const auto* variant = &(value->value);
+  auto* write = dispatch(STREAM_VALUE, variant->type);
+  if (write == nullptr) {
+    string error_msg = "Unhandled UA_Variant type detected: " +
+        string(variant->type->typeName);
+    throw logic_error(error_msg);
+  }
+  write(stream, node_key, toString(value->sourceTimestamp),
+      toString(value->serverTimestamp), *variant);
 }
 
 UA_DateTime toUaDateTime(const string& data) {
@@ -243,233 +532,266 @@ UA_DateTime toUaDateTime(const string& data) {
   using namespace chrono;
 
   istringstream string_stream{data};
-  system_clock::time_point time_point;
+  sys_time<microseconds> time_point;
   string_stream >> parse("%F %T", time_point);
+  if (string_stream.fail()) {
+    throw logic_error("Malformed timestamp " + data);
+  }
+  return toUaDateTime(time_point.time_since_epoch().count());
+}
 
-  UA_DateTimeStruct calendar_time;
-  auto day_point = floor<days>(time_point);
-  auto calender_date = year_month_day{day_point};
-  // NOLINTNEXTLINE(bugprone-narrowing-conversions)
-  calendar_time.year = static_cast<UA_Int16>(int{calender_date.year()});
-  calendar_time.month = static_cast<UA_UInt16>(unsigned{calender_date.month()});
-  calendar_time.day = static_cast<UA_UInt16>(unsigned{calender_date.day()});
+template <typename Type> struct FromField {
+  static UA_Variant apply(const field& data) {
+    using T = typename Type::type;
+    UA_Variant result;
+    UA_Variant_init(&result);
+    T value;
+    if constexpr (Type::kind == UA_DATATYPEKIND_DATETIME) {
+      value = toUaDateTime(data.as<string>());
+    } else if constexpr (Type::kind == UA_DATATYPEKIND_BYTESTRING) {
+      auto opaque = binarystring(data);
+      value.length = opaque.size();
+      value.data = (UA_Byte*)opaque.bytes();
+      // copies the bytes, before opaque releases them
+      UA_Variant_setScalarCopy(&result, &value, Type::dataType());
+      return result;
+    } else if constexpr (Type::kind == UA_DATATYPEKIND_STRING) {
+      auto text = data.as<string>();
+      value.length = text.size();
+      value.data = (UA_Byte*)text.data();
+      UA_Variant_setScalarCopy(&result, &value, Type::dataType());
+      return result;
+    } else if constexpr (is_integral_v<T> && sizeof(T) < sizeof(int64_t) &&
+        Type::kind != UA_DATATYPEKIND_BOOLEAN) {
+      // narrow integers are stored in wider or domain restricted columns
+      value = static_cast<T>(data.as<int64_t>());
+    } else {
+      value = data.as<T>();
+    }
+    UA_Variant_setScalarCopy(&result, &value, Type::dataType());
+    return result;
+  }
+};
 
-  auto day_time = hh_mm_ss{time_point - day_point};
-  calendar_time.hour = static_cast<UA_UInt16>(day_time.hours().count());
-  calendar_time.min = static_cast<UA_UInt16>(day_time.minutes().count());
-  calendar_time.sec = static_cast<UA_UInt16>(day_time.seconds().count());
-  calendar_time.milliSec =
-      static_cast<UA_UInt16>(floor<milliseconds>(day_time.seconds()).count());
-  calendar_time.microSec =
-      static_cast<UA_UInt16>(floor<microseconds>(day_time.seconds()).count());
-  calendar_time.nanoSec =
-      static_cast<UA_UInt16>(floor<nanoseconds>(day_time.seconds()).count());
-
-  return UA_DateTime_fromStruct(calendar_time);
-}
+constexpr auto FROM_FIELD =
+    makeDispatchTable<UA_Variant(const field&), FromField>(ScalarTypes{});
 
 UA_Variant toUaVariant(const field& data, const TypeMap& type_map) {
-  UA_Variant result;
-  UA_Variant_init(&result);
   auto type = type_map.at(data.type());
-  switch (type) {
-  case UA_DataTypeKind::UA_DATATYPEKIND_BOOLEAN: {
-    auto value = data.as<bool>();
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_BOOLEAN]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_BYTE: {
-    auto value = static_cast<uint8_t>(data.as<int>());
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_BYTE]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_SBYTE: {
-    auto value = static_cast<int8_t>(data.as<int>());
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_SBYTE]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT16: {
-    auto value = static_cast<uint16_t>(data.as<int>());
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT16]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT16: {
-    auto value = static_cast<int16_t>(data.as<int>());
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT16]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT32: {
-    auto value = static_cast<uint32_t>(data.as<long>());
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT32]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT32: {
-    auto value = data.as<int32_t>();
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT32]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT64: {
-    auto value = static_cast<uint64_t>(data.as<long>());
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT64]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT64: {
-    auto value = data.as<long>();
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT64]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_STATUSCODE: {
-    auto value = data.as<int>();
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_STATUSCODE]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_FLOAT: {
-    auto value = data.as<float>();
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_FLOAT]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_DOUBLE: {
-    auto value = data.as<double>();
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_DATETIME: {
-    auto timestamp = data.as<string>();
-    auto value = toUaDateTime(timestamp);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_DATETIME]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_BYTESTRING: {
-    auto opaque = binarystring(data);
-    UA_ByteString value;
-    value.length = opaque.size();
-    value.data = (UA_Byte*)malloc(value.length);
-    memcpy(value.data, opaque.bytes(), value.length);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_BYTESTRING]);
-    UA_String_clear(&value);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_STRING: {
-    auto cpp_string = data.as<string>();
-    UA_String value = UA_String_fromChars(cpp_string.c_str());
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_STRING]);
-    UA_String_clear(&value);
-    break;
-  }
-  default: {
+  auto* convert = dispatch(FROM_FIELD, type);
+  if (convert == nullptr) {
     throw logic_error("Unhandled UA Data Type " + std::to_string(type));
   }
-  }
-
-  return result;
+  return convert(data);
 }
 
-UA_ByteString* makeContinuationPoint(intmax_t last_index) {
-  string index = to_string(last_index);
-  UA_ByteString* result = UA_ByteString_new(); // should it be on heap?
-  auto status = UA_ByteString_allocBuffer(result, index.size());
-  if (status == UA_STATUSCODE_GOOD) {
-    memcpy(result->data, index.c_str(), index.size());
-  } else {
+// version tag, followed by the Unix epoch microseconds and the index
+constexpr UA_Byte CONTINUATION_POINT_VERSION = 1;
+constexpr size_t CONTINUATION_POINT_SIZE = 1 + 2 * sizeof(int64_t);
+
+UA_ByteString makeContinuationPoint(const ContinuationPoint& position) {
+  UA_ByteString result;
+  if (UA_ByteString_allocBuffer(&result, CONTINUATION_POINT_SIZE) !=
+      UA_STATUSCODE_GOOD) {
     throw OutOfMemory();
   }
+  result.data[0] = CONTINUATION_POINT_VERSION;
+  memcpy(result.data + 1, &position.source_micros, sizeof(int64_t));
+  memcpy(result.data + 1 + sizeof(int64_t), &position.index, sizeof(int64_t));
   return result;
 }
 
-HistoryResults makeHistoryResults(const result& rows,
-    UA_TimestampsToReturn timestamps_to_return, const TypeMap& type_map) {
-  HistoryResults result;
-  for (const auto& row : rows) {
-    result.push_back(makeHistoryResult(row, timestamps_to_return, type_map));
+optional<ContinuationPoint> readContinuationPoint(
+    const UA_ByteString* continuation_point) {
+  if (continuation_point == nullptr || continuation_point->length == 0) {
+    return nullopt;
   }
+  if (continuation_point->length != CONTINUATION_POINT_SIZE ||
+      continuation_point->data[0] != CONTINUATION_POINT_VERSION) {
+    throw invalid_argument("Malformed continuation point");
+  }
+  ContinuationPoint result;
+  memcpy(&result.source_micros, continuation_point->data + 1, sizeof(int64_t));
+  memcpy(&result.index, continuation_point->data + 1 + sizeof(int64_t),
+      sizeof(int64_t));
   return result;
 }
 
-HistoryResult makeHistoryResult(const row& entry,
+void setTimestamps(UA_DataValue* data_value,
+    UA_TimestampsToReturn timestamps_to_return, UA_DateTime source_timestamp,
+    UA_DateTime server_timestamp) {
+  if (timestamps_to_return == UA_TIMESTAMPSTORETURN_SOURCE ||
+      timestamps_to_return == UA_TIMESTAMPSTORETURN_BOTH) {
+    data_value->sourceTimestamp = source_timestamp;
+    data_value->hasSourceTimestamp = true;
+  }
+  if (timestamps_to_return == UA_TIMESTAMPSTORETURN_SERVER ||
+      timestamps_to_return == UA_TIMESTAMPSTORETURN_BOTH) {
+    data_value->serverTimestamp = server_timestamp;
+    data_value->hasServerTimestamp = true;
+  }
+}
+
+void appendHistoryResult(HistoryResults* results, const row& entry,
     UA_TimestampsToReturn timestamps_to_return, const TypeMap& type_map) {
-  HistoryResult result{// clang-format off
-      .index = entry["Index"].as<long>(),
-      .value = toUaVariant(entry["Value"], type_map),
-      .source_timestamp = "", 
-      .server_timestamp = ""
-    }; // clang-format on
+  auto& result = results->append();
+  result.value = toUaVariant(entry["Value"], type_map);
+  result.hasValue = !UA_Variant_isEmpty(&result.value);
   if (timestamps_to_return != UA_TIMESTAMPSTORETURN_NEITHER) {
-    if (timestamps_to_return == UA_TIMESTAMPSTORETURN_SOURCE ||
-        timestamps_to_return == UA_TIMESTAMPSTORETURN_BOTH) {
-      result.source_timestamp = entry["Source_Timestamp"].as<string>();
-    }
-    if (timestamps_to_return == UA_TIMESTAMPSTORETURN_SERVER ||
-        timestamps_to_return == UA_TIMESTAMPSTORETURN_BOTH) {
-      result.server_timestamp = entry["Server_Timestamp"].as<string>();
-    }
+    setTimestamps(&result, timestamps_to_return,
+        toUaDateTime(entry["Source_Micros"].as<int64_t>()),
+        toUaDateTime(entry["Server_Micros"].as<int64_t>()));
   }
-  return result;
 }
 
 UA_StatusCode appendUADataValue(UA_HistoryData* result,
     UA_DataValue* data_points, size_t data_points_size) {
+  if (data_points_size == 0) {
+    UA_free(data_points);
+    return UA_STATUSCODE_GOOD;
+  }
   if (result->dataValuesSize == 0) {
     // no previous data to append to
+    UA_Array_delete(result->dataValues, 0, &UA_TYPES[UA_TYPES_DATAVALUE]);
     result->dataValuesSize = data_points_size;
     result->dataValues = data_points;
     return UA_STATUSCODE_GOOD;
-  } else {
-    UA_StatusCode status = UA_STATUSCODE_BAD; // nothing was appended
-    for (size_t i = 0; i < data_points_size; ++i) {
-      // there is no method in open62541 to expand an existing array with
-      // another array of the same type, so we need to manually append values
-      status = UA_Array_append( // use UA_Array_appendCopy instead?
-          (void**)&(result->dataValues), &result->dataValuesSize,
-          &(data_points[i]), &UA_TYPES[UA_TYPES_DATAVALUE]);
-      if (status != UA_STATUSCODE_GOOD) {
-        // early return for failure
-        return status;
-      }
-    }
-    return status;
   }
+  // data values are moved by copying their bytes, only the array is freed
+  auto* expanded = static_cast<UA_DataValue*>(UA_realloc(result->dataValues,
+      (result->dataValuesSize + data_points_size) * sizeof(UA_DataValue)));
+  if (expanded == nullptr) {
+    UA_Array_delete(
+        data_points, data_points_size, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    return UA_STATUSCODE_BADOUTOFMEMORY;
+  }
+  memcpy(expanded + result->dataValuesSize, data_points,
+      data_points_size * sizeof(UA_DataValue));
+  UA_free(data_points);
+  result->dataValues = expanded;
+  result->dataValuesSize += data_points_size;
+  return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode expandHistoryResult(
-    UA_HistoryData* result, const HistoryResults& rows) {
-  auto* data =
-      (UA_DataValue*)UA_Array_new(rows.size(), &UA_TYPES[UA_TYPES_DATAVALUE]);
-  if (data == nullptr) {
-    return UA_STATUSCODE_BADOUTOFMEMORY;
-  }
+    UA_HistoryData* result, HistoryResults&& rows) {
+  auto size = rows.size();
+  return appendUADataValue(result, rows.release(), size);
+}
 
-  for (size_t index = 0; index < rows.size(); ++index) {
-    data[index].hasValue = true;
-    data[index].hasSourceTimestamp = false;
-    data[index].hasServerTimestamp = false;
-    data[index].value = rows[index].value;
-    if (!rows[index].source_timestamp.empty()) {
-      data[index].hasSourceTimestamp = true;
-      data[index].sourceTimestamp = toUaDateTime(rows[index].source_timestamp);
+UA_StatusCode selectIndexRange(
+    UA_HistoryData* result, const UA_String& index_range) {
+  if (index_range.length == 0) {
+    return UA_STATUSCODE_GOOD;
+  }
+  UA_NumericRange range;
+  if (UA_NumericRange_parse(&range, index_range) != UA_STATUSCODE_GOOD) {
+    return UA_STATUSCODE_BADINDEXRANGEINVALID;
+  }
+  for (size_t i = 0; i < result->dataValuesSize; ++i) {
+    auto& data_value = result->dataValues[i];
+    if (!data_value.hasValue) {
+      continue;
     }
-    if (!rows[index].server_timestamp.empty()) {
-      data[index].hasServerTimestamp = true;
-      data[index].sourceTimestamp = toUaDateTime(rows[index].server_timestamp);
+    UA_Variant selected;
+    UA_Variant_init(&selected);
+    auto copied = UA_Variant_copyRange(&data_value.value, &selected, range);
+    if (copied == UA_STATUSCODE_BADOUTOFMEMORY) {
+      UA_free(range.dimensions);
+      throw OutOfMemory();
+    }
+    UA_Variant_clear(&data_value.value);
+    if (copied == UA_STATUSCODE_GOOD) {
+      data_value.value = selected;
+    } else {
+      data_value.hasValue = false;
+      data_value.hasStatus = true;
+      data_value.status = UA_STATUSCODE_BADINDEXRANGENODATA;
     }
   }
-
-  return appendUADataValue(result, data, rows.size());
+  UA_free(range.dimensions);
+  return UA_STATUSCODE_GOOD;
 }
 
-HistoryResult interpolateValues(UA_DateTime target_timestamp,
-    const HistoryResult& before, const HistoryResult& after) {
-  auto before_timestamp = toUaDateTime(before.server_timestamp);
-  auto after_timestamp = toUaDateTime(after.server_timestamp);
-  // use formula from OPC UA Part 13 Aggregates specification section 3.1.8
-  intmax_t weight = target_timestamp - before_timestamp;
-  auto value_diff = after.value - before.value;
-  intmax_t denominator = after_timestamp - before_timestamp;
-  auto interpolated = ((value_diff * weight) / denominator) + before.value;
+// integer values are interpolated in 128 bit arithmetic, since doubles can
+// not represent all 64 bit integers
+using Int128 = __int128;
+
+/**
+ * @brief Rounds before + (after - before) * elapsed / span half away from
+ * zero and clamps it to the range of T
+ *
+ */
+template <typename T>
+T interpolateInteger(T before, T after, int64_t elapsed, int64_t span) {
+  auto numerator =
+      (static_cast<Int128>(after) - static_cast<Int128>(before)) * elapsed;
+  auto step = numerator / span;
+  auto remainder = numerator % span;
+  if (2 * (remainder < 0 ? -remainder : remainder) >= span) {
+    step += numerator < 0 ? -1 : 1;
+  }
+  auto result = static_cast<Int128>(before) + step;
+  if (result < static_cast<Int128>(numeric_limits<T>::min())) {
+    return numeric_limits<T>::min();
+  }
+  if (result > static_cast<Int128>(numeric_limits<T>::max())) {
+    return numeric_limits<T>::max();
+  }
+  return static_cast<T>(result);
+}
 
-  return HistoryResult{.index = -1,
-      .value = interpolated,
-      .source_timestamp = toString(target_timestamp),
-      .server_timestamp = toString(target_timestamp)};
+template <typename Type> struct Interpolate {
+  static UA_Variant apply(const UA_Variant& before, const UA_Variant& after,
+      int64_t elapsed, int64_t span) {
+    using T = typename Type::type;
+    T interpolated;
+    if constexpr (is_floating_point_v<T>) {
+      auto before_value = static_cast<double>(Type::value(before));
+      auto slope = (static_cast<double>(Type::value(after)) - before_value) /
+          static_cast<double>(span);
+      interpolated =
+          static_cast<T>(before_value + slope * static_cast<double>(elapsed));
+    } else {
+      interpolated = interpolateInteger<T>(
+          Type::value(before), Type::value(after), elapsed, span);
+    }
+    UA_Variant result;
+    UA_Variant_init(&result);
+    if (UA_Variant_setScalarCopy(&result, &interpolated, Type::dataType()) !=
+        UA_STATUSCODE_GOOD) {
+      throw OutOfMemory();
+    }
+    return result;
+  }
+};
+
+constexpr auto INTERPOLATE = makeDispatchTable<UA_Variant(const UA_Variant&,
+                                                   const UA_Variant&, int64_t,
+                                                   int64_t),
+    Interpolate, true>(ScalarTypes{});
+
+UA_Variant interpolateValue(int64_t target, int64_t before_time,
+    const UA_Variant& before, int64_t after_time, const UA_Variant& after) {
+  if (before.type != after.type) {
+    throw logic_error("Can not interpolate non matching value types");
+  }
+  auto* interpolate = dispatch(INTERPOLATE, before.type);
+  if (interpolate == nullptr) {
+    throw logic_error("Can not interpolate " +
+        string(before.type == nullptr ? "Empty" : before.type->typeName) +
+        " values");
+  }
+  if (after_time <= before_time) {
+    // both bounding values have the same timestamp
+    UA_Variant result;
+    if (UA_Variant_copy(&before, &result) != UA_STATUSCODE_GOOD) {
+      throw OutOfMemory();
+    }
+    return result;
+  }
+  return interpolate(
+      before, after, target - before_time, after_time - before_time);
 }
 
 } // namespace open62541
\ No newline at end of file
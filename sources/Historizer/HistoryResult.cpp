@@ -0,0 +1,72 @@
+#include "HistoryResult.hpp"
+#include "Exceptions.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace open62541 {
+using namespace std;
+
+HistoryResults::~HistoryResults() { clear(); }
+
+HistoryResults::HistoryResults(HistoryResults&& other) noexcept
+    : values_(exchange(other.values_, nullptr)),
+      size_(exchange(other.size_, 0)),
+      capacity_(exchange(other.capacity_, 0)) {}
+
+HistoryResults& HistoryResults::operator=(HistoryResults&& other) noexcept {
+  if (this != &other) {
+    clear();
+    values_ = exchange(other.values_, nullptr);
+    size_ = exchange(other.size_, 0);
+    capacity_ = exchange(other.capacity_, 0);
+  }
+  return *this;
+}
+
+void HistoryResults::reserve(size_t capacity) {
+  if (capacity <= capacity_) {
+    return;
+  }
+  // UA_DataValue is moved by copying its bytes, so the array can be
+  // reallocated like any other open62541 array
+  auto* expanded = static_cast<UA_DataValue*>(
+      UA_realloc(values_, capacity * sizeof(UA_DataValue)));
+  if (expanded == nullptr) {
+    throw OutOfMemory();
+  }
+  values_ = expanded;
+  capacity_ = capacity;
+}
+
+UA_DataValue& HistoryResults::append() {
+  if (size_ == capacity_) {
+    reserve(max<size_t>(2 * capacity_, 1));
+  }
+  auto& result = values_[size_++];
+  UA_DataValue_init(&result);
+  return result;
+}
+
+void HistoryResults::reverse() { std::reverse(values_, values_ + size_); }
+
+UA_DataValue* HistoryResults::release() {
+  if (size_ == 0) {
+    clear();
+    return nullptr;
+  }
+  size_ = 0;
+  capacity_ = 0;
+  return exchange(values_, nullptr);
+}
+
+void HistoryResults::clear() {
+  for (size_t i = 0; i < size_; ++i) {
+    UA_DataValue_clear(&values_[i]);
+  }
+  UA_free(values_);
+  values_ = nullptr;
+  size_ = 0;
+  capacity_ = 0;
+}
+} // namespace open62541
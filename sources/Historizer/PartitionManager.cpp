@@ -0,0 +1,140 @@
+#include "PartitionManager.hpp"
+#include "HistorizerUtils.hpp"
+#include "LogFacade.hpp"
+
+#include <HaSLL/LoggerManager.hpp>
+#include <date/date.h>
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cctype>
+#include <set>
+
+namespace open62541 {
+using namespace std;
+using namespace HaSLL;
+using namespace pqxx;
+
+// checking for expired partitions more often would not drop them any sooner
+constexpr auto RETENTION_CHECK_INTERVAL = chrono::hours(1);
+
+string toLowerCase(string value) {
+  transform(value.begin(), value.end(), value.begin(),
+      [](unsigned char character) { return tolower(character); });
+  return value;
+}
+
+string toTimestampLiteral(int64_t unix_micros) {
+  return date::format("%Y-%m-%d %H:%M:%S",
+      date::sys_time<chrono::microseconds>(chrono::microseconds(unix_micros)));
+}
+
+PartitionManager::PartitionManager(
+    ConnectionPool* pool, const StorageConfig& config)
+    : pool_(pool), config_(config),
+      logger_(LoggerManager::registerLogger("Open62541::PartitionManager")),
+      next_retention_check_(chrono::steady_clock::now()) {
+  if (config_.partition_interval.count() <= 0) {
+    throw invalid_argument("Partition interval must be at least one hour");
+  }
+}
+
+int64_t PartitionManager::intervalMicros() const {
+  return chrono::duration_cast<chrono::microseconds>(
+      config_.partition_interval)
+      .count();
+}
+
+void PartitionManager::ensurePartitions(
+    const string& relation, const vector<int64_t>& source_micros) {
+  auto interval = intervalMicros();
+  set<int64_t> starts;
+  for (auto micros : source_micros) {
+    // floor the timestamp, so values before the epoch are aligned as well
+    starts.insert(micros - (((micros % interval) + interval) % interval));
+  }
+
+  lock_guard lock(mx_);
+  relations_.insert(relation);
+  for (auto start : starts) {
+    createPartition(relation, start);
+  }
+
+  if (config_.retention.count() > 0 &&
+      chrono::steady_clock::now() >= next_retention_check_) {
+    next_retention_check_ =
+        chrono::steady_clock::now() + RETENTION_CHECK_INTERVAL;
+    try {
+      auto dropped = removeExpired();
+      if (dropped > 0) {
+        logger_->info("Dropped {} expired history partitions", dropped);
+      }
+    } catch (const exception& ex) {
+      logger_->warning("Failed to drop expired history partitions. "
+                       "Exception: {}",
+          ex.what());
+    }
+  }
+}
+
+void PartitionManager::createPartition(
+    const string& relation, int64_t start_micros) {
+  // unquoted identifiers are folded to lower case by the database
+  auto name = toLowerCase(relation) + "_p" +
+      date::format("%Y%m%d%H",
+          date::sys_time<chrono::microseconds>(
+              chrono::microseconds(start_micros)));
+  if (partitions_.find(name) != partitions_.end()) {
+    return;
+  }
+  withSession(pool_,
+      [&relation, &name, start_micros, this](PooledConnection& session) {
+        work transaction(*session);
+        transaction.exec(fmt::format("CREATE TABLE IF NOT EXISTS {} PARTITION "
+                                     "OF {} FOR VALUES FROM ('{}') TO ('{}');",
+            name, relation, toTimestampLiteral(start_micros),
+            toTimestampLiteral(start_micros + intervalMicros())));
+        transaction.commit();
+      });
+  partitions_.insert(name);
+  OPEN62541_TRACE(logger_, "Created history partition {}", name);
+}
+
+size_t PartitionManager::dropExpired() {
+  lock_guard lock(mx_);
+  return removeExpired();
+}
+
+size_t PartitionManager::removeExpired() {
+  if (relations_.empty()) {
+    return 0;
+  }
+  auto cutoff = chrono::duration_cast<chrono::microseconds>(
+      chrono::system_clock::now().time_since_epoch() - config_.retention);
+  vector<string> relations(relations_.begin(), relations_.end());
+
+  return withSession(pool_,
+      [&relations, &cutoff, this](PooledConnection& session) {
+        work transaction(*session);
+        // partition bounds are only available as the text of the FOR VALUES
+        // clause, so the upper bound is extracted from it
+        auto expired = transaction.exec(
+            "SELECT Child.relname FROM pg_inherits JOIN pg_class AS Child ON "
+            "Child.oid = pg_inherits.inhrelid JOIN pg_class AS Parent ON "
+            "Parent.oid = pg_inherits.inhparent WHERE Parent.relname = ANY("
+            "SELECT LOWER(Name) FROM unnest($1::TEXT[]) AS Name) AND "
+            "(regexp_match(pg_get_expr(Child.relpartbound, Child.oid), "
+            "'TO \\(''([^'']+)''\\)'))[1]::TIMESTAMP <= " +
+                fromUnixMicroseconds("$2") + ";",
+            params{relations, cutoff.count()});
+        for (const auto& row : expired) {
+          auto name = row["relname"].as<string>();
+          transaction.exec(
+              "DROP TABLE IF EXISTS " + transaction.quote_name(name) + ";");
+          partitions_.erase(name);
+        }
+        transaction.commit();
+        return static_cast<size_t>(expired.size());
+      });
+}
+} // namespace open62541
@@ -0,0 +1,281 @@
+#include "RetentionManager.hpp"
+
+#include <HaSLL/LoggerManager.hpp>
+#include <fmt/format.h>
+
+namespace open62541 {
+using namespace std;
+using namespace HaSLL;
+using namespace pqxx;
+
+int64_t toMicros(chrono::seconds interval) {
+  return chrono::duration_cast<chrono::microseconds>(interval).count();
+}
+
+int64_t floorTo(int64_t micros, int64_t step) {
+  return micros - (((micros % step) + step) % step);
+}
+
+/**
+ * @brief Oldest Unix epoch microseconds timestamp, that is still retained,
+ * INT64_MIN if the values are kept forever
+ */
+int64_t retainedSince(chrono::hours retention) {
+  if (retention.count() == 0) {
+    return INT64_MIN;
+  }
+  return toUnixMicroseconds(UA_DateTime_now()) -
+      chrono::duration_cast<chrono::microseconds>(retention).count();
+}
+
+RetentionManager::RetentionManager(
+    ConnectionPool* pool, const RetentionConfig& config)
+    : pool_(pool), config_(config),
+      logger_(LoggerManager::registerLogger("Open62541::RetentionManager")) {
+  for (const auto& policy : config_.policies) {
+    for (size_t i = 0; i < policy.rollups.size(); ++i) {
+      auto interval = policy.rollups[i].interval.count();
+      auto previous = i > 0 ? policy.rollups[i - 1].interval.count() : 1;
+      bool ascending = i == 0 || interval > previous;
+      // every tier is calculated from the previous one
+      if (interval <= 0 || !ascending || interval % previous != 0) {
+        throw invalid_argument("Rollup intervals of retention policy " +
+            policy.pattern + " must be ascending multiples of each other");
+      }
+      // the last two intervals of a tier are recalculated from the values of
+      // the previous tier, so they must not have been deleted yet
+      auto source_retention =
+          i > 0 ? policy.rollups[i - 1].retention : policy.max_age;
+      if (source_retention.count() > 0 &&
+          source_retention < 2 * policy.rollups[i].interval) {
+        throw invalid_argument("Retention of the values, that rollup tier " +
+            to_string(i) + " of retention policy " + policy.pattern +
+            " is calculated from, must be at least twice its interval");
+      }
+    }
+    patterns_.emplace_back(policy.pattern);
+  }
+
+  withSession(pool_, [](PooledConnection& session) {
+    work transaction(*session);
+    transaction.exec(fmt::format("CREATE TABLE IF NOT EXISTS {}("
+                                 "Node_ID TEXT NOT NULL, "
+                                 "Interval_Seconds INTEGER NOT NULL, "
+                                 "Bucket_Start TIMESTAMP NOT NULL, "
+                                 "Sample_Count BIGINT NOT NULL, "
+                                 "Minimum FLOAT8, "
+                                 "Maximum FLOAT8, "
+                                 "Average FLOAT8, "
+                                 "PRIMARY KEY (Node_ID, Interval_Seconds, "
+                                 "Bucket_Start));",
+        ROLLUP_TABLE));
+    transaction.commit();
+  });
+  // all nodes and tiers share the same statements
+  rollup_statements_ = registerRollupStatements(pool_, "rollup");
+  thread_ = thread(&RetentionManager::run, this);
+}
+
+RetentionManager::~RetentionManager() {
+  running_ = false;
+  wake_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void RetentionManager::track(
+    const string& table, const NodeStorage& storage, bool numeric) {
+  for (size_t policy = 0; policy < patterns_.size(); ++policy) {
+    if (!regex_match(table, patterns_[policy])) {
+      continue;
+    }
+    TrackedNode node{storage, policy, {}};
+    if (numeric) {
+      for (const auto& rollup : config_.policies[policy].rollups) {
+        node.tiers.push_back(Tier{rollup});
+      }
+    }
+    unique_lock lock(nodes_mx_);
+    nodes_.insert_or_assign(table, move(node));
+    return;
+  }
+}
+
+optional<NodeStatements> RetentionManager::rollupForRaw(
+    const string& table, int64_t lower_micros, int64_t upper_micros) const {
+  shared_lock lock(nodes_mx_);
+  auto it = nodes_.find(table);
+  if (it == nodes_.end()) {
+    return nullopt;
+  }
+  const auto& policy = config_.policies[it->second.policy];
+  if (policy.max_age.count() == 0 ||
+      upper_micros >= retainedSince(policy.max_age)) {
+    return nullopt;
+  }
+  for (const auto& tier : it->second.tiers) {
+    if (lower_micros >= retainedSince(tier.config.retention) &&
+        upper_micros <= tier.complete_until) {
+      return rollupStatements(table, tier);
+    }
+  }
+  return nullopt;
+}
+
+optional<NodeStatements> RetentionManager::rollupForAggregate(
+    const string& table, Aggregate aggregate, int64_t lower_micros,
+    int64_t upper_micros, int64_t width_micros) const {
+  if (aggregate != Aggregate::Average && aggregate != Aggregate::Minimum &&
+      aggregate != Aggregate::Maximum && aggregate != Aggregate::Count) {
+    return nullopt;
+  }
+  shared_lock lock(nodes_mx_);
+  auto it = nodes_.find(table);
+  if (it == nodes_.end()) {
+    return nullopt;
+  }
+  const auto& tiers = it->second.tiers;
+  for (auto tier = tiers.rbegin(); tier != tiers.rend(); ++tier) {
+    // every processing interval must consist of whole rollup intervals
+    auto interval = toMicros(tier->config.interval);
+    if (lower_micros % interval == 0 && upper_micros % interval == 0 &&
+        width_micros % interval == 0 &&
+        lower_micros >= retainedSince(tier->config.retention) &&
+        upper_micros <= tier->complete_until) {
+      return rollupStatements(table, *tier);
+    }
+  }
+  return nullopt;
+}
+
+NodeStatements RetentionManager::rollupStatements(
+    const string& table, const Tier& tier) const {
+  auto result = rollup_statements_;
+  result.rollup =
+      RollupKey{table, static_cast<int32_t>(tier.config.interval.count())};
+  return result;
+}
+
+void RetentionManager::run() {
+  while (running_) {
+    {
+      unique_lock lock(wake_mx_);
+      wake_.wait_for(
+          lock, config_.maintenance_interval, [this]() { return !running_; });
+    }
+    if (running_) {
+      runMaintenance();
+    }
+  }
+}
+
+void RetentionManager::runMaintenance() {
+  vector<pair<string, TrackedNode>> nodes;
+  {
+    shared_lock lock(nodes_mx_);
+    nodes.assign(nodes_.begin(), nodes_.end());
+  }
+  for (const auto& [table, node] : nodes) {
+    if (!running_) {
+      return;
+    }
+    try {
+      maintain(table, node);
+    } catch (const exception& ex) {
+      logger_->error("Failed to apply retention policy to {} node. "
+                     "Exception: {}",
+          table, ex.what());
+    }
+  }
+}
+
+void RetentionManager::maintain(const string& table, const TrackedNode& node) {
+  auto started = toUnixMicroseconds(UA_DateTime_now());
+  const auto& policy = config_.policies[node.policy];
+  auto from = selectFrom(node.storage);
+  auto interval = "($2::INTEGER * INTERVAL '1 second')";
+  // the last rollup interval is recalculated, since it was incomplete or
+  // could have received late values
+  auto watermark = fmt::format(
+      "COALESCE((SELECT MAX(Bucket_Start) FROM {0} WHERE Node_ID = $1 AND "
+      "Interval_Seconds = $2::INTEGER) - {1}, '-infinity')",
+      ROLLUP_TABLE, interval);
+  auto upsert = fmt::format(
+      "INSERT INTO {} (Node_ID, Interval_Seconds, Bucket_Start, Sample_Count, "
+      "Minimum, Maximum, Average) ",
+      ROLLUP_TABLE);
+  auto on_conflict = "ON CONFLICT (Node_ID, Interval_Seconds, Bucket_Start) "
+                     "DO UPDATE SET Sample_Count = EXCLUDED.Sample_Count, "
+                     "Minimum = EXCLUDED.Minimum, Maximum = EXCLUDED.Maximum, "
+                     "Average = EXCLUDED.Average;";
+
+  withSession(pool_, [&](PooledConnection& session) {
+    work transaction(*session);
+    // all rollups are updated before the values, they are calculated from,
+    // are deleted
+    for (size_t i = 0; i < node.tiers.size(); ++i) {
+      const auto& tier = node.tiers[i].config;
+      auto seconds = static_cast<int32_t>(tier.interval.count());
+      if (i == 0) {
+        transaction.exec(
+            fmt::format("{0}SELECT $1, $2::INTEGER, date_bin({1}, "
+                        "Source_Timestamp, TIMESTAMP 'epoch') AS Bucket, "
+                        "COUNT(*), MIN(Value::FLOAT8), MAX(Value::FLOAT8), "
+                        "AVG(Value::FLOAT8) FROM {2}Source_Timestamp >= {3} "
+                        "GROUP BY Bucket {4}",
+                upsert, interval, from, watermark, on_conflict),
+            params{table, seconds});
+      } else {
+        auto previous =
+            static_cast<int32_t>(node.tiers[i - 1].config.interval.count());
+        transaction.exec(
+            fmt::format("{0}SELECT $1, $2::INTEGER, date_bin({1}, "
+                        "Bucket_Start, TIMESTAMP 'epoch') AS Bucket, "
+                        "SUM(Sample_Count), MIN(Minimum), MAX(Maximum), "
+                        "SUM(Average * Sample_Count) / NULLIF(SUM("
+                        "Sample_Count), 0) FROM {2} WHERE Node_ID = $1 AND "
+                        "Interval_Seconds = $3 AND Bucket_Start >= {3} GROUP "
+                        "BY Bucket {4}",
+                upsert, interval, ROLLUP_TABLE, watermark, on_conflict),
+            params{table, seconds, previous});
+      }
+    }
+    for (const auto& tier : node.tiers) {
+      const auto& rollup = tier.config;
+      if (rollup.retention.count() > 0) {
+        transaction.exec(
+            fmt::format("DELETE FROM {} WHERE Node_ID = $1 AND "
+                        "Interval_Seconds = $2 AND Bucket_Start < {};",
+                ROLLUP_TABLE, fromUnixMicroseconds("$3")),
+            params{table, static_cast<int32_t>(rollup.interval.count()),
+                retainedSince(rollup.retention)});
+      }
+    }
+
+    if (policy.max_age.count() > 0) {
+      transaction.exec("DELETE FROM " + from + "Source_Timestamp < " +
+              fromUnixMicroseconds("$1") + ";",
+          params{retainedSince(policy.max_age)});
+    }
+    if (policy.max_rows > 0) {
+      transaction.exec(
+          fmt::format("DELETE FROM {0}(Source_Timestamp, Index) <= (SELECT "
+                      "Source_Timestamp, Index FROM {0}TRUE ORDER BY "
+                      "Source_Timestamp DESC, Index DESC OFFSET $1 LIMIT 1);",
+              from),
+          params{static_cast<int64_t>(policy.max_rows)});
+    }
+    transaction.commit();
+  });
+
+  unique_lock lock(nodes_mx_);
+  auto it = nodes_.find(table);
+  if (it == nodes_.end()) {
+    return;
+  }
+  for (auto& tier : it->second.tiers) {
+    tier.complete_until = floorTo(started, toMicros(tier.config.interval));
+  }
+}
+} // namespace open62541
@@ -1,9 +1,12 @@
 #include "CallbackRepo.hpp"
+#include "LogFacade.hpp"
 #include "StringConverter.hpp"
 #include "VariantConverter.hpp"
 
 #include <HaSLL/LoggerManager.hpp>
 #include <open62541/plugin/log.h>
+
+#include <algorithm>
 #include <stdexcept>
 
 namespace open62541 {
@@ -39,18 +42,39 @@ struct NotCallable : runtime_error {
   NotCallable() : runtime_error("") {}
 };
 
-CallbackRepo* getCallbackRepo(void* context_ptr) {
+// removed records are only reused after this, see CallbackRecord
+constexpr auto RECORD_QUARANTINE = chrono::seconds(10);
+
+CallbackRecord* getCallbackRecord(void* context_ptr) {
   if (context_ptr == nullptr) {
     throw NoCallbackRepo();
   }
 
-  auto* repo = static_cast<CallbackRepo*>(context_ptr);
-  if (repo == nullptr) {
+  auto* record = static_cast<CallbackRecord*>(context_ptr);
+  if (record->repo == nullptr) {
     throw NoCallbackRepo();
   }
-  return repo;
+  return record;
 }
 
+/**
+ * @brief Marks the given record as used by a callback, for as long as it
+ * exists, so the record is not reused in the meantime
+ */
+struct InFlight {
+  explicit InFlight(CallbackRecord* record) : record_(record) {
+    ++record_->in_flight;
+  }
+
+  InFlight(const InFlight&) = delete;
+  InFlight& operator=(const InFlight&) = delete;
+
+  ~InFlight() { --record_->in_flight; }
+
+private:
+  CallbackRecord* record_;
+};
+
 UA_Logger* getLogger(UA_Server* server) {
   auto* config = UA_Server_getConfig(server);
   if (config == nullptr) {
@@ -96,14 +120,27 @@ UA_StatusCode handleExceptions(
   }
 }
 
+/**
+ * @brief Async method calls are answered with BadTimeout by the server after
+ * asyncOperationTimeout, waiting for the device result any longer is useless
+ */
+optional<chrono::milliseconds> getMethodTimeout(UA_Server* server) {
+  auto* config = UA_Server_getConfig(server);
+  if (config == nullptr || config->asyncOperationTimeout <= 0) {
+    return nullopt;
+  }
+  return chrono::milliseconds(
+      static_cast<int64_t>(config->asyncOperationTimeout));
+}
+
 UA_StatusCode readNodeValue(UA_Server* server, const UA_NodeId*, void*,
-    const UA_NodeId* node_id, void* node_context, UA_Boolean,
-    const UA_NumericRange*, UA_DataValue* value) {
+    const UA_NodeId* node_id, void* node_context,
+    UA_Boolean include_source_timestamp, const UA_NumericRange* range,
+    UA_DataValue* value) {
   try {
-    UA_LOG_TRACE(getLogger(server), UA_LOGCATEGORY_SERVER,
-        "Calling read callback for Node %s", toString(node_id).c_str());
-    auto* repo = getCallbackRepo(node_context);
-    return repo->read(node_id, value);
+    auto* record = getCallbackRecord(node_context);
+    return record->repo->read(
+        record, node_id, value, include_source_timestamp, range);
   } catch (const NotReadable&) {
     UA_LOG_ERROR(getLogger(server), UA_LOGCATEGORY_SERVER,
         "Node %s is not readable", toString(node_id).c_str());
@@ -114,11 +151,24 @@ UA_StatusCode readNodeValue(UA_Server* server, const UA_NodeId*, void*,
 }
 
 UA_StatusCode writeNodeValue(UA_Server* server, const UA_NodeId*, void*,
-    const UA_NodeId* node_id, void* node_context, const UA_NumericRange*,
+    const UA_NodeId* node_id, void* node_context, const UA_NumericRange* range,
     const UA_DataValue* value) {
+  if (range != nullptr && range->dimensionsSize > 0) {
+    // devices only accept whole values
+    UA_LOG_WARNING(getLogger(server), UA_LOGCATEGORY_SERVER,
+        "Node %s does not support index range writes",
+        toString(node_id).c_str());
+    return UA_STATUSCODE_BADWRITENOTSUPPORTED;
+  }
+  if (value == nullptr || !UA_Variant_isScalar(&value->value)) {
+    // nodes are scalar, the Information Model has no array values
+    UA_LOG_WARNING(getLogger(server), UA_LOGCATEGORY_SERVER,
+        "Node %s only accepts scalar values", toString(node_id).c_str());
+    return UA_STATUSCODE_BADTYPEMISMATCH;
+  }
   try {
-    auto* repo = getCallbackRepo(node_context);
-    return repo->write(node_id, value);
+    auto* record = getCallbackRecord(node_context);
+    return record->repo->write(record, node_id, value);
   } catch (const NotWritable&) {
     UA_LOG_ERROR(getLogger(server), UA_LOGCATEGORY_SERVER,
         "Node %s is not writable", toString(node_id).c_str());
@@ -133,8 +183,9 @@ UA_StatusCode callNodeMethod(UA_Server* server, const UA_NodeId*, void*,
     size_t input_size, const UA_Variant* input, size_t output_size,
     UA_Variant* output) {
   try {
-    auto* repo = getCallbackRepo(method_context);
-    return repo->execute(method_id, input_size, input, output_size, output);
+    auto* record = getCallbackRecord(method_context);
+    return record->repo->execute(record, method_id, input_size, input,
+        output_size, output, getMethodTimeout(server));
   } catch (const NotWritable&) {
     UA_LOG_ERROR(getLogger(server), UA_LOGCATEGORY_SERVER,
         "Node %s is not executable", toString(method_id).c_str());
@@ -144,61 +195,239 @@ UA_StatusCode callNodeMethod(UA_Server* server, const UA_NodeId*, void*,
   }
 }
 
-CallbackRepo::CallbackRepo()
-    : logger_(LoggerManager::registerLogger("Open62541::CallbackRepo")) {}
+CallbackRepo::CallbackRepo(const ReadDispatcherConfig& config)
+    : logger_(LoggerManager::registerLogger("Open62541::CallbackRepo")),
+      dispatcher_(make_unique<ReadDispatcher>(config)) {}
 
-UA_StatusCode CallbackRepo::add(
-    UA_NodeId node_id, const CallbackWrapper& wrapper) {
+UA_StatusCode CallbackRepo::add(UA_NodeId node_id,
+    const CallbackWrapper& wrapper, const string& device_id) {
   if (std::holds_alternative<monostate>(wrapper)) {
     throw CallbackNotFound();
   }
 
-  UA_StatusCode status = UA_STATUSCODE_GOOD;
-  callbacks_.visit(node_id,
-      [&status](const auto&) { status = UA_STATUSCODE_BADNODEIDEXISTS; });
-  if (status != UA_STATUSCODE_GOOD) {
+  auto* record = allocate();
+  record->device_id = device_id;
+  record->wrapper = wrapper;
+  if (std::holds_alternative<ReadablePtr>(wrapper) ||
+      std::holds_alternative<WritablePtr>(wrapper)) {
+    // resolved once, so reads do not match the read rules every time
+    record->limits = dispatcher_->limits(toString(&node_id));
+  }
+  if (!callbacks_.emplace(node_id, record)) {
     logger_->error(
         "Node {} was already registered earlier", toString(&node_id));
-  } else {
-    logger_->trace("Adding wrapper for Node {}", toString(&node_id));
-    callbacks_.emplace(node_id, wrapper);
+    record->device_id.clear();
+    release(NodeId(node_id), record);
+    return UA_STATUSCODE_BADNODEIDEXISTS;
   }
-  return status;
+  if (!device_id.empty()) {
+    devices_.try_emplace_or_visit(device_id, vector<NodeId>{node_id},
+        [&node_id](auto& pair) { pair.second.emplace_back(node_id); });
+  }
+  OPEN62541_TRACE(logger_, "Adding wrapper for Node {}", toString(&node_id));
+  return UA_STATUSCODE_GOOD;
+}
+
+void* CallbackRepo::nodeContext(const UA_NodeId& node_id) {
+  CallbackRecord* result = nullptr;
+  callbacks_.visit(
+      node_id, [&result](const auto& pair) { result = pair.second; });
+  return result;
 }
 
 void CallbackRepo::remove(const UA_NodeId* node_id) {
-  logger_->trace("Removing callbacks for Node {}", toString(node_id));
-  callbacks_.erase_if(
-      [node_id](const auto& pair) { return pair.first == *node_id; });
+  OPEN62541_TRACE(logger_, "Removing callbacks for Node {}", toString(node_id));
+  NodeId id(*node_id);
+  CallbackRecord* record = nullptr;
+  callbacks_.erase_if(id, [&record](const auto& pair) {
+    record = pair.second;
+    return true;
+  });
+  if (record == nullptr) {
+    // subscription could still exist, if adding the node failed
+    observers_.erase(id);
+    return;
+  }
+  if (!record->device_id.empty()) {
+    devices_.visit(record->device_id, [&id](auto& pair) {
+      auto& nodes = pair.second;
+      nodes.erase(std::remove(nodes.begin(), nodes.end(), id), nodes.end());
+    });
+  }
+  release(id, record);
+}
+
+size_t CallbackRepo::removeDevice(const string& device_id) {
+  OPEN62541_TRACE(logger_, "Removing callbacks for Device {}", device_id);
+  vector<NodeId> nodes;
+  devices_.erase_if(device_id, [&nodes](auto& pair) {
+    nodes = move(pair.second);
+    return true;
+  });
+
+  size_t removed = 0;
+  for (const auto& node_id : nodes) {
+    CallbackRecord* record = nullptr;
+    callbacks_.erase_if(node_id, [&record](const auto& pair) {
+      record = pair.second;
+      return true;
+    });
+    if (record != nullptr) {
+      release(node_id, record);
+      ++removed;
+    }
+  }
+  OPEN62541_TRACE(logger_,
+      "Removed callbacks of {} nodes for Device {}", removed, device_id);
+  return removed;
+}
+
+CallbackRecord* CallbackRepo::allocate() {
+  lock_guard lock(records_mx_);
+  auto now = chrono::steady_clock::now();
+  while (!quarantined_records_.empty()) {
+    auto* record = quarantined_records_.front();
+    if (now - record->removed_at < RECORD_QUARANTINE ||
+        record->in_flight > 0) {
+      break;
+    }
+    quarantined_records_.pop_front();
+    record->device_id.clear();
+    record->wrapper = monostate();
+    {
+      lock_guard cache_lock(record->cache_mx);
+      record->cache = CallbackRecord::CachedRead();
+      record->last = CallbackRecord::CachedRead();
+    }
+    record->limits = ReadLimits();
+    record->removed = false;
+    free_records_.push_back(record);
+  }
+
+  CallbackRecord* result = nullptr;
+  if (free_records_.empty()) {
+    // deque keeps the addresses of its elements, when it grows at the end
+    result = &records_.emplace_back();
+  } else {
+    result = free_records_.back();
+    free_records_.pop_back();
+  }
+  result->repo = this;
+  return result;
+}
+
+void CallbackRepo::release(const NodeId& node_id, CallbackRecord* record) {
+  // destroying the observer ends the subscription
+  observers_.erase(node_id);
+  lock_guard lock(records_mx_);
+  record->removed = true;
+  record->removed_at = chrono::steady_clock::now();
+  quarantined_records_.push_back(record);
 }
 
 CallbackWrapper CallbackRepo::find(const UA_NodeId* node_id) {
   CallbackWrapper result;
-  callbacks_.visit(
-      *node_id, [&result](const auto& pair) { result = pair.second; });
+  callbacks_.visit(*node_id,
+      [&result](const auto& pair) { result = pair.second->wrapper; });
   if (std::holds_alternative<monostate>(result)) {
     throw CallbackNotFound();
   }
   return result;
 }
 
-UA_StatusCode CallbackRepo::read(
-    const UA_NodeId* node_id, UA_DataValue* value) {
-  logger_->trace("Calling read callback for Node {}", toString(node_id));
+namespace {
+bool succeeded(const shared_future<DataVariant>& value) {
+  try {
+    value.get();
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+} // namespace
+
+optional<DataVariant> CallbackRepo::dispatch(CallbackRecord* record,
+    const UA_NodeId* node_id, ReadDispatcher::Reader&& reader,
+    UA_DateTime& source_timestamp) {
+  const auto& limits = record->limits;
+  auto now = chrono::steady_clock::now();
+  CallbackRecord::CachedRead cached;
+  CallbackRecord::CachedRead last;
+  {
+    // only one of the concurrent readers, that found no fresh value, starts
+    // a device read, the others wait for its result
+    lock_guard lock(record->cache_mx);
+    auto& entry = record->cache;
+    bool in_flight = entry.value.valid() &&
+        entry.value.wait_for(chrono::seconds(0)) != future_status::ready;
+    bool fresh =
+        entry.value.valid() && now - entry.requested <= limits.max_age;
+    if (!in_flight && !fresh) {
+      if (entry.value.valid() && succeeded(entry.value)) {
+        record->last = entry;
+      }
+      entry.value = dispatcher_->dispatch(move(reader)).share();
+      entry.requested = now;
+      entry.source_timestamp = UA_DateTime_now();
+    }
+    cached = entry;
+    last = record->last;
+  }
+
+  bool usable = last.value.valid() &&
+      now - last.requested <= limits.max_age + limits.stale_age;
+  if (usable &&
+      cached.value.wait_for(chrono::seconds(0)) != future_status::ready) {
+    // the server thread does not wait for the device, the in flight read
+    // replaces the returned value once it finishes
+    source_timestamp = last.source_timestamp;
+    return last.value.get();
+  }
+  if (cached.value.wait_for(limits.timeout) != future_status::ready) {
+    // the worker finishes the read in the background and caches its value
+    logger_->warning("Reading Node {} did not finish within {} ms",
+        toString(node_id), limits.timeout.count());
+    return nullopt;
+  }
+  source_timestamp = cached.source_timestamp;
+  try {
+    return cached.value.get();
+  } catch (...) {
+    // a failed read is not reused, the next read retries the device
+    lock_guard lock(record->cache_mx);
+    if (record->cache.requested == cached.requested) {
+      record->cache = CallbackRecord::CachedRead();
+    }
+    throw;
+  }
+}
+
+UA_StatusCode CallbackRepo::read(CallbackRecord* record,
+    const UA_NodeId* node_id, UA_DataValue* value,
+    bool include_source_timestamp, const UA_NumericRange* range) {
+  InFlight in_flight(record);
+  OPEN62541_TRACE(
+      logger_, "Calling read callback for Node {}", toString(node_id));
 
   try {
     DataType target_type = DataType::Unknown;
     DataVariant result;
+    optional<UA_DateTime> source_timestamp;
 
-    auto wrapper = find(node_id);
+    if (record->removed) {
+      throw CallbackNotFound();
+    }
+    const auto& wrapper = record->wrapper;
     if (std::holds_alternative<ObservablePtr>(wrapper)) {
-      auto observable = std::get<ObservablePtr>(wrapper);
-      logger_->trace("Calling read from Observable Node {}", toString(node_id));
+      const auto& observable = std::get<ObservablePtr>(wrapper);
+      OPEN62541_TRACE(
+          logger_, "Calling read from Observable Node {}", toString(node_id));
       target_type = observable->dataType();
       result = observable->read();
     } else if (std::holds_alternative<WritablePtr>(wrapper)) {
-      auto writable = std::get<WritablePtr>(wrapper);
-      logger_->trace("Calling read from Writable Node {}", toString(node_id));
+      const auto& writable = std::get<WritablePtr>(wrapper);
+      OPEN62541_TRACE(
+          logger_, "Calling read from Writable Node {}", toString(node_id));
       target_type = writable->dataType();
       if (writable->isWriteOnly()) {
         // set default data as dummy to avoid bad internal error
@@ -208,18 +437,47 @@ UA_StatusCode CallbackRepo::read(
         logger_->warning(
             "Node {} does not support read operation", toString(node_id));
       } else {
-        result = writable->read();
+        UA_DateTime read_at = 0;
+        auto dispatched = dispatch(record, node_id,
+            [writable]() { return writable->read(); }, read_at);
+        if (!dispatched) {
+          return UA_STATUSCODE_BADTIMEOUT;
+        }
+        result = move(*dispatched);
+        source_timestamp = read_at;
       }
     } else {
-      auto readable = std::get<ReadablePtr>(wrapper);
-      logger_->trace("Calling read from Readable Node {}", toString(node_id));
+      const auto& readable = std::get<ReadablePtr>(wrapper);
+      OPEN62541_TRACE(
+          logger_, "Calling read from Readable Node {}", toString(node_id));
       target_type = readable->dataType();
-      result = readable->read();
+      UA_DateTime read_at = 0;
+      auto dispatched = dispatch(record, node_id,
+          [readable]() { return readable->read(); }, read_at);
+      if (!dispatched) {
+        return UA_STATUSCODE_BADTIMEOUT;
+      }
+      result = move(*dispatched);
+      source_timestamp = read_at;
     }
 
     if (toDataType(result) == target_type) {
-      value->value = toUAVariant(result);
+      if (range != nullptr && range->dimensionsSize > 0) {
+        // only the selected part of the value is copied
+        auto status = toUAVariant(result, *range, &value->value);
+        if (status != UA_STATUSCODE_GOOD) {
+          return status;
+        }
+      } else {
+        toUAVariant(result, &value->value);
+      }
       value->hasValue = true;
+      if (include_source_timestamp && source_timestamp) {
+        // cached values keep the time of the device read, so clients can
+        // tell their age
+        value->sourceTimestamp = *source_timestamp;
+        value->hasSourceTimestamp = true;
+      }
       return UA_STATUSCODE_GOOD;
     } else {
       logger_->error("Expected to receive {} data type, but received {} "
@@ -232,20 +490,38 @@ UA_StatusCode CallbackRepo::read(
     throw NotReadable();
   } catch (const CallbackNotFound&) {
     throw; // rethrow CallbackNotFound
+  } catch (const ReadQueueFull& ex) {
+    logger_->warning("Rejected read of Node {}: {}", toString(node_id),
+        ex.what());
+    return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+  } catch (const future_error&) {
+    // the dispatcher was destroyed before a worker picked up the read
+    return UA_STATUSCODE_BADSHUTDOWN;
   } catch (const exception& ex) {
     remove(node_id);
     throw BadOperation(ex.what());
   }
 }
 
-UA_StatusCode CallbackRepo::write(
+UA_StatusCode CallbackRepo::write(CallbackRecord* record,
     const UA_NodeId* node_id, const UA_DataValue* value) {
-  logger_->trace("Calling write callback for Node %s", toString(node_id));
+  InFlight in_flight(record);
+  OPEN62541_TRACE(
+      logger_, "Calling write callback for Node {}", toString(node_id));
   try {
-    auto writable = std::get<WritablePtr>(find(node_id));
+    if (record->removed) {
+      throw CallbackNotFound();
+    }
+    const auto& writable = std::get<WritablePtr>(record->wrapper);
     auto data_variant = toDataVariant(value->value);
     if (toDataType(data_variant) == writable->dataType()) {
       writable->write(data_variant);
+      {
+        // reads after the write must not return the overwritten value
+        lock_guard lock(record->cache_mx);
+        record->cache = CallbackRecord::CachedRead();
+        record->last = CallbackRecord::CachedRead();
+      }
       return UA_STATUSCODE_GOOD;
     } else {
       logger_->error("Expected to write {} data type, but writing {} instead "
@@ -264,12 +540,80 @@ UA_StatusCode CallbackRepo::write(
   }
 }
 
-UA_StatusCode CallbackRepo::execute(const UA_NodeId* method_id,
-    size_t input_size, const UA_Variant* input, size_t output_size,
-    UA_Variant* output) {
-  logger_->trace("Calling Method callback for Node {}", toString(method_id));
+UA_StatusCode CallbackRepo::observe(
+    UA_Server* server, const UA_NodeId* node_id) {
+  OPEN62541_TRACE(
+      logger_, "Subscribing to Observable Node {}", toString(node_id));
   try {
-    auto callable = std::get<CallablePtr>(find(method_id));
+    auto observable = std::get<ObservablePtr>(find(node_id));
+    auto type = observable->dataType();
+    auto observer = observable->subscribe(
+        [this, server, id = NodeId(*node_id), type](
+            const shared_ptr<DataVariant>& value) {
+          if (value) {
+            update(server, id, type, *value);
+          }
+        },
+        [this, id = NodeId(*node_id)](const exception_ptr& error) {
+          try {
+            rethrow_exception(error);
+          } catch (const exception& ex) {
+            logger_->error("Observable Node {} failed to notify a value: {}",
+                toString(&id.base()), ex.what());
+          } catch (...) {
+            logger_->error("Observable Node {} failed to notify a value",
+                toString(&id.base()));
+          }
+        });
+    observers_.insert_or_assign(NodeId(*node_id), observer);
+    return UA_STATUSCODE_GOOD;
+  } catch (const bad_variant_access&) {
+    logger_->error("Node {} is not observable", toString(node_id));
+    return UA_STATUSCODE_BADNOTSUPPORTED;
+  } catch (const CallbackNotFound&) {
+    throw; // rethrow CallbackNotFound
+  } catch (const exception& ex) {
+    logger_->error("Failed to subscribe to Observable Node {}: {}",
+        toString(node_id), ex.what());
+    return UA_STATUSCODE_BADINTERNALERROR;
+  }
+}
+
+void CallbackRepo::update(UA_Server* server, const NodeId& node_id,
+    DataType type, const DataVariant& value) {
+  if (toDataType(value) != type) {
+    logger_->error("Expected to receive {} data type, but received {} "
+                   "instead from Node {}",
+        toString(type), toString(toDataType(value)), toString(&node_id.base()));
+    return;
+  }
+  UA_DataValue data_value;
+  UA_DataValue_init(&data_value);
+  toUAVariant(value, &data_value.value);
+  data_value.hasValue = true;
+  // the value was observed now, not when the server processes the write
+  data_value.sourceTimestamp = UA_DateTime_now();
+  data_value.hasSourceTimestamp = true;
+  auto status = UA_Server_writeDataValue(server, node_id.base(), data_value);
+  if (status != UA_STATUSCODE_GOOD) {
+    logger_->error("Failed to update Observable Node {} value: {}",
+        toString(&node_id.base()), UA_StatusCode_name(status));
+  }
+  UA_DataValue_clear(&data_value);
+}
+
+UA_StatusCode CallbackRepo::execute(CallbackRecord* record,
+    const UA_NodeId* method_id, size_t input_size, const UA_Variant* input,
+    size_t output_size, UA_Variant* output,
+    optional<chrono::milliseconds> timeout) {
+  InFlight in_flight(record);
+  OPEN62541_TRACE(
+      logger_, "Calling Method callback for Node {}", toString(method_id));
+  try {
+    if (record->removed) {
+      throw CallbackNotFound();
+    }
+    const auto& callable = std::get<CallablePtr>(record->wrapper);
 
     auto supported_params = callable->parameterTypes();
     if (supported_params.size() < input_size) {
@@ -285,19 +629,26 @@ UA_StatusCode CallbackRepo::execute(const UA_NodeId* method_id,
     }
 
     if (output_size == 0) {
-      logger_->trace(
+      OPEN62541_TRACE(logger_,
           "Calling Method callback for Node {}", toString(method_id));
       callable->execute(params);
       return UA_STATUSCODE_GOOD;
     }
 
-    logger_->trace("Calling Method callback with results for Node {}",
+    OPEN62541_TRACE(logger_, "Calling Method callback with results for Node {}",
         toString(method_id));
-    auto result_variant = callable->call(params);
+    auto result_future = callable->asyncCall(params);
+    if (timeout &&
+        result_future.wait_for(*timeout) != future_status::ready) {
+      callable->cancelAsyncCall(result_future.id());
+      logger_->warning("Cancelled Method {} call, since it did not finish "
+                       "within {} ms",
+          toString(method_id), timeout->count());
+      return UA_STATUSCODE_BADTIMEOUT;
+    }
+    auto result_variant = result_future.get();
     if (toDataType(result_variant) == callable->resultType()) {
-      auto ua_variant = toUAVariant(result_variant);
-      UA_Variant_copy(&ua_variant, output);
-      UA_Variant_clear(&ua_variant);
+      toUAVariant(result_variant, output);
       return UA_STATUSCODE_GOOD;
     } else {
       logger_->error("Expected to receive {} data type, but received {} "
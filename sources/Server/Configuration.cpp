@@ -1,5 +1,6 @@
 #include "Configuration.hpp"
 #include "CheckStatus.hpp"
+#include "LogFacade.hpp"
 #include "Logger.hpp"
 
 #ifdef ENABLE_UA_HISTORIZING
@@ -7,6 +8,8 @@
 #endif // ENABLE_UA_HISTORIZING
 
 #include <HaSLL/LoggerManager.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
 #include <open62541/server_config_default.h>
 #include <open62541/server_config_file_based.h>
 
@@ -55,6 +58,240 @@ UA_ByteString readFile(const filesystem::path& filepath) {
   return result;
 }
 
+chrono::milliseconds getMilliseconds(const boost::property_tree::ptree& tree,
+    const string& path, chrono::milliseconds default_value) {
+  return chrono::milliseconds(tree.get(path, default_value.count()));
+}
+
+ReadLimits readLimits(
+    const boost::property_tree::ptree& tree, const ReadLimits& defaults) {
+  ReadLimits result = defaults;
+  result.timeout = getMilliseconds(tree, "timeout", result.timeout);
+  result.max_age = getMilliseconds(tree, "maxAge", result.max_age);
+  result.stale_age = getMilliseconds(tree, "staleAge", result.stale_age);
+  return result;
+}
+
+/**
+ * @brief Reads the optional "readDispatcher" section of the server
+ * configuration file, open62541 ignores it, since it is not a part of
+ * UA_ServerConfig
+ */
+ReadDispatcherConfig readDispatcherConfig(
+    const boost::property_tree::ptree& config) {
+  ReadDispatcherConfig result;
+  auto dispatcher = config.get_child_optional("readDispatcher");
+  if (!dispatcher) {
+    return result;
+  }
+
+  result.workers = dispatcher->get("workers", result.workers);
+  result.queue_capacity =
+      dispatcher->get("queueCapacity", result.queue_capacity);
+  // rules inherit the limits, that they do not set, from the defaults
+  auto& defaults = result.defaults;
+  defaults = readLimits(*dispatcher, defaults);
+  if (auto rules = dispatcher->get_child_optional("rules")) {
+    for (const auto& [key, rule] : *rules) {
+      ReadRule parsed;
+      parsed.pattern = rule.get("pattern", parsed.pattern);
+      parsed.limits = readLimits(rule, defaults);
+      result.rules.push_back(parsed);
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief Reads the optional "runner" section of the server configuration
+ * file, open62541 ignores it, since it is not a part of UA_ServerConfig
+ *
+ * @throws std::invalid_argument if the mode is unknown
+ */
+RunnerConfig readRunnerConfig(const boost::property_tree::ptree& config) {
+  RunnerConfig result;
+  auto runner = config.get_child_optional("runner");
+  if (!runner) {
+    return result;
+  }
+
+  if (auto mode = runner->get_optional<string>("mode")) {
+    if (*mode == "singleThread") {
+      result.mode = RunnerMode::SINGLE_THREAD;
+    } else if (*mode == "workerPool") {
+      result.mode = RunnerMode::WORKER_POOL;
+    } else {
+      throw invalid_argument("Unknown runner mode: " + *mode);
+    }
+  }
+  result.workers = runner->get("workers", result.workers);
+  return result;
+}
+
+/**
+ * @brief Reads the optional "registration" section of the server
+ * configuration file, open62541 ignores it, since it is not a part of
+ * UA_ServerConfig
+ */
+RegistrationConfig readRegistrationConfig(
+    const boost::property_tree::ptree& config) {
+  RegistrationConfig result;
+  auto registration = config.get_child_optional("registration");
+  if (!registration) {
+    return result;
+  }
+
+  result.workers = registration->get("workers", result.workers);
+  result.queue_capacity =
+      registration->get("queueCapacity", result.queue_capacity);
+  return result;
+}
+
+#ifdef ENABLE_UA_HISTORIZING
+
+OverflowPolicy toOverflowPolicy(const string& value) {
+  if (value == "block") {
+    return OverflowPolicy::Block;
+  } else if (value == "dropOldest") {
+    return OverflowPolicy::DropOldest;
+  } else if (value == "spillToDisk") {
+    return OverflowPolicy::SpillToDisk;
+  }
+  throw invalid_argument("Unknown historizer overflow policy: " + value);
+}
+
+StorageLayout toStorageLayout(const string& value) {
+  if (value == "tablePerNode") {
+    return StorageLayout::TablePerNode;
+  } else if (value == "partitioned") {
+    return StorageLayout::Partitioned;
+  }
+  throw invalid_argument("Unknown historizer storage layout: " + value);
+}
+
+chrono::hours getHours(const boost::property_tree::ptree& tree,
+    const string& path, chrono::hours default_value) {
+  return chrono::hours(tree.get(path, default_value.count()));
+}
+
+DeadbandType toDeadbandType(const string& value) {
+  if (value == "none") {
+    return DeadbandType::None;
+  } else if (value == "absolute") {
+    return DeadbandType::Absolute;
+  } else if (value == "percent") {
+    return DeadbandType::Percent;
+  }
+  throw invalid_argument("Unknown historizer deadband type: " + value);
+}
+
+MonitoringParameters readMonitoringParameters(
+    const boost::property_tree::ptree& tree,
+    const MonitoringParameters& defaults) {
+  MonitoringParameters result = defaults;
+  result.sampling_interval =
+      tree.get("samplingInterval", result.sampling_interval);
+  if (auto deadband = tree.get_optional<string>("deadbandType")) {
+    result.deadband_type = toDeadbandType(*deadband);
+  }
+  result.deadband_value = tree.get("deadbandValue", result.deadband_value);
+  result.queue_size = tree.get("queueSize", result.queue_size);
+  result.discard_oldest = tree.get("discardOldest", result.discard_oldest);
+  return result;
+}
+
+RetentionPolicy readRetentionPolicy(const boost::property_tree::ptree& tree) {
+  RetentionPolicy result;
+  result.pattern = tree.get("pattern", result.pattern);
+  result.max_age = getHours(tree, "maxAge", result.max_age);
+  result.max_rows = tree.get("maxRows", result.max_rows);
+  if (auto rollups = tree.get_child_optional("rollups")) {
+    for (const auto& [key, rollup] : *rollups) {
+      RollupTier tier;
+      tier.interval =
+          chrono::seconds(rollup.get("interval", tier.interval.count()));
+      tier.retention = getHours(rollup, "retention", tier.retention);
+      result.rollups.push_back(tier);
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief Reads the optional "historizer" section of the server configuration
+ * file, open62541 ignores it, since it is not a part of UA_ServerConfig
+ */
+HistorizerConfig readHistorizerConfig(
+    const boost::property_tree::ptree& config) {
+  HistorizerConfig result;
+  auto historizer = config.get_child_optional("historizer");
+  if (!historizer) {
+    return result;
+  }
+
+  result.pool.connection =
+      historizer->get("connection", result.pool.connection);
+  if (auto pool = historizer->get_child_optional("connectionPool")) {
+    result.pool.min_size = pool->get("minSize", result.pool.min_size);
+    result.pool.max_size = pool->get("maxSize", result.pool.max_size);
+    result.pool.acquire_timeout =
+        getMilliseconds(*pool, "acquireTimeout", result.pool.acquire_timeout);
+    result.pool.health_check_interval = getMilliseconds(
+        *pool, "healthCheckInterval", result.pool.health_check_interval);
+  }
+  if (auto writer = historizer->get_child_optional("writer")) {
+    result.writer.queue_capacity =
+        writer->get("queueCapacity", result.writer.queue_capacity);
+    result.writer.batch_size =
+        writer->get("batchSize", result.writer.batch_size);
+    result.writer.flush_interval = getMilliseconds(
+        *writer, "flushInterval", result.writer.flush_interval);
+    if (auto policy = writer->get_optional<string>("overflowPolicy")) {
+      result.writer.overflow_policy = toOverflowPolicy(*policy);
+    }
+    result.writer.spill_file =
+        writer->get("spillFile", result.writer.spill_file.string());
+  }
+  if (auto storage = historizer->get_child_optional("storage")) {
+    if (auto layout = storage->get_optional<string>("layout")) {
+      result.storage.layout = toStorageLayout(*layout);
+    }
+    result.storage.partition_interval = getHours(
+        *storage, "partitionInterval", result.storage.partition_interval);
+    result.storage.retention =
+        getHours(*storage, "retention", result.storage.retention);
+  }
+  if (auto retention = historizer->get_child_optional("retention")) {
+    result.retention.maintenance_interval = getMilliseconds(*retention,
+        "maintenanceInterval", result.retention.maintenance_interval);
+    if (auto policies = retention->get_child_optional("policies")) {
+      for (const auto& [key, policy] : *policies) {
+        result.retention.policies.push_back(readRetentionPolicy(policy));
+      }
+    }
+  }
+  if (auto processed = historizer->get_child_optional("processed")) {
+    result.processed.max_intervals =
+        processed->get("maxIntervals", result.processed.max_intervals);
+  }
+  if (auto monitoring = historizer->get_child_optional("monitoring")) {
+    // rules inherit the parameters, that they do not set, from the defaults
+    auto& defaults = result.monitoring.defaults;
+    defaults = readMonitoringParameters(*monitoring, defaults);
+    if (auto rules = monitoring->get_child_optional("rules")) {
+      for (const auto& [key, rule] : *rules) {
+        MonitoringRule parsed;
+        parsed.pattern = rule.get("pattern", parsed.pattern);
+        parsed.data_type = rule.get("dataType", parsed.data_type);
+        parsed.parameters = readMonitoringParameters(rule, defaults);
+        result.monitoring.rules.push_back(parsed);
+      }
+    }
+  }
+  return result;
+}
+#endif // ENABLE_UA_HISTORIZING
+
 Configuration::Configuration(const filesystem::path& filepath)
     : Configuration() {
   UA_ByteString json_config = readFile(filepath);
@@ -65,10 +302,25 @@ Configuration::Configuration(const filesystem::path& filepath)
       "While reading configuration file " + filepath.string(), status, true);
   UA_String_clear(&json_config);
 
+  boost::property_tree::ptree config;
+  try {
+    boost::property_tree::read_json(filepath.string(), config);
+    read_dispatcher_ = readDispatcherConfig(config);
+    runner_ = readRunnerConfig(config);
+    registration_ = readRegistrationConfig(config);
+    if (auto threshold = config.get_optional<string>("logThreshold")) {
+      setLogThreshold(toSeverityLevel(*threshold));
+    }
+  } catch (exception& ex) {
+    logger_->error("Using the default read dispatcher, runner, registration "
+                   "and logging configuration, due to an exception: {}",
+        ex.what());
+  }
+
 #ifdef ENABLE_UA_HISTORIZING
   if (configuration_->historizingEnabled) {
     try {
-      historizer_ = make_shared<Historizer>();
+      historizer_ = make_shared<Historizer>(readHistorizerConfig(config));
       configuration_->historyDatabase = createDatabaseStruct(historizer_);
     } catch (exception& ex) {
       logger_->error("Data Historization Service will not be available, due to "
@@ -83,6 +335,16 @@ unique_ptr<UA_ServerConfig> Configuration::getConfig() {
   return move(configuration_);
 }
 
+ReadDispatcherConfig Configuration::getReadDispatcherConfig() const {
+  return read_dispatcher_;
+}
+
+RunnerConfig Configuration::getRunnerConfig() const { return runner_; }
+
+RegistrationConfig Configuration::getRegistrationConfig() const {
+  return registration_;
+}
+
 #ifdef ENABLE_UA_HISTORIZING
 HistorizerPtr Configuration::getHistorizer() const { return historizer_; }
 #endif // ENABLE_UA_HISTORIZING
@@ -1,36 +1,150 @@
 #include "Logger.hpp"
 #include "HaSLL/LoggerManager.hpp"
+#include "LogFacade.hpp"
 
-#include <unordered_map>
+#include <boost/lockfree/queue.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
 
 namespace open62541 {
 using namespace std;
 using namespace HaSLL;
 
-using LoggersMap = unordered_map<UA_LogCategory, LoggerPtr>;
-
-LoggersMap* registerLoggers() {
-  auto* result = new LoggersMap;
-  result->emplace(UA_LogCategory::UA_LOGCATEGORY_NETWORK,
-      LoggerManager::registerLogger("Open62541::Network"));
-  result->emplace(UA_LogCategory::UA_LOGCATEGORY_SECURECHANNEL,
-      LoggerManager::registerLogger("Open62541::Channel"));
-  result->emplace(UA_LogCategory::UA_LOGCATEGORY_SESSION,
-      LoggerManager::registerLogger("Open62541::Session"));
-  result->emplace(UA_LogCategory::UA_LOGCATEGORY_SERVER,
-      LoggerManager::registerLogger("Open62541::Server"));
-  result->emplace(UA_LogCategory::UA_LOGCATEGORY_CLIENT,
-      LoggerManager::registerLogger("Open62541::Client"));
-  result->emplace(UA_LogCategory::UA_LOGCATEGORY_USERLAND,
-      LoggerManager::registerLogger("Open62541::User"));
-  result->emplace(UA_LogCategory::UA_LOGCATEGORY_SECURITYPOLICY,
-      LoggerManager::registerLogger("Open62541::Security"));
-  result->emplace(UA_LogCategory::UA_LOGCATEGORY_EVENTLOOP,
-      LoggerManager::registerLogger("Open62541::EventLoop"));
-  result->emplace(UA_LogCategory::UA_LOGCATEGORY_DISCOVERY,
-      LoggerManager::registerLogger("Open62541::Discovery"));
-  return result;
-}
+// boost::lockfree fixed sized queues use 16 bit node indexes
+constexpr uint16_t LOG_SLOTS = 1024;
+// longer messages are truncated
+constexpr size_t LOG_MESSAGE_SIZE = 512;
+constexpr size_t LOG_CATEGORIES = UA_LOGCATEGORY_DISCOVERY + 1;
+// each category may log this many messages per rate limit period
+constexpr int64_t LOG_RATE_LIMIT = 500;
+constexpr auto LOG_RATE_PERIOD = chrono::seconds(1);
+// upper bound for the delay of a message, if its wake up notification is
+// missed by the drain thread
+constexpr auto LOG_DRAIN_INTERVAL = chrono::milliseconds(100);
+
+struct LogSlot {
+  SeverityLevel level;
+  size_t category;
+  size_t length;
+  array<char, LOG_MESSAGE_SIZE> text;
+};
+
+/**
+ * @brief Allows at most LOG_RATE_LIMIT messages per LOG_RATE_PERIOD and
+ * counts the suppressed messages
+ */
+struct RateLimiter {
+  /**
+   * @return int64_t - -1 if the message must be dropped, otherwise the
+   * number of messages, that were suppressed since the previous period
+   */
+  int64_t acquire(int64_t now) {
+    auto period_start = period_start_.load(memory_order_relaxed);
+    auto period = chrono::duration_cast<chrono::nanoseconds>(LOG_RATE_PERIOD);
+    if (now - period_start >= period.count() &&
+        period_start_.compare_exchange_strong(period_start, now)) {
+      tokens_.store(LOG_RATE_LIMIT, memory_order_relaxed);
+      return static_cast<int64_t>(suppressed_.exchange(0));
+    }
+    if (tokens_.fetch_sub(1, memory_order_relaxed) > 0) {
+      return 0;
+    }
+    suppressed_.fetch_add(1, memory_order_relaxed);
+    return -1;
+  }
+
+private:
+  atomic<int64_t> tokens_ = LOG_RATE_LIMIT;
+  atomic<int64_t> period_start_ = 0;
+  atomic<uint64_t> suppressed_ = 0;
+};
+
+/**
+ * @brief Context of the HaSLL UA_Logger. Log calls format the message into a
+ * free preallocated slot and queue it, a background thread passes the queued
+ * messages to HaSLL, so the calling server thread never waits for HaSLL
+ */
+struct LogBridge {
+  LogBridge() {
+    loggers[UA_LOGCATEGORY_NETWORK] =
+        LoggerManager::registerLogger("Open62541::Network");
+    loggers[UA_LOGCATEGORY_SECURECHANNEL] =
+        LoggerManager::registerLogger("Open62541::Channel");
+    loggers[UA_LOGCATEGORY_SESSION] =
+        LoggerManager::registerLogger("Open62541::Session");
+    loggers[UA_LOGCATEGORY_SERVER] =
+        LoggerManager::registerLogger("Open62541::Server");
+    loggers[UA_LOGCATEGORY_CLIENT] =
+        LoggerManager::registerLogger("Open62541::Client");
+    loggers[UA_LOGCATEGORY_USERLAND] =
+        LoggerManager::registerLogger("Open62541::User");
+    loggers[UA_LOGCATEGORY_SECURITYPOLICY] =
+        LoggerManager::registerLogger("Open62541::Security");
+    loggers[UA_LOGCATEGORY_EVENTLOOP] =
+        LoggerManager::registerLogger("Open62541::EventLoop");
+    loggers[UA_LOGCATEGORY_DISCOVERY] =
+        LoggerManager::registerLogger("Open62541::Discovery");
+    for (uint16_t i = 0; i < LOG_SLOTS; ++i) {
+      free_slots.push(i);
+    }
+    drainer = thread(&LogBridge::run, this);
+  }
+
+  ~LogBridge() {
+    running = false;
+    wake.notify_all();
+    if (drainer.joinable()) {
+      drainer.join();
+    }
+  }
+
+  void run() {
+    while (running) {
+      drain();
+      unique_lock lock(wake_mx);
+      wake.wait_for(lock, LOG_DRAIN_INTERVAL,
+          [this]() { return !running || !queued_slots.empty(); });
+    }
+    // pass on the messages, that were queued during shutdown
+    drain();
+  }
+
+  void drain() {
+    uint16_t index = 0;
+    while (queued_slots.pop(index)) {
+      const auto& slot = slots[index];
+      if (const auto& logger = loggers[slot.category]; logger) {
+        logger->log(slot.level, string(slot.text.data(), slot.length));
+      }
+      free_slots.push(index);
+    }
+    if (auto dropped = dropped_messages.exchange(0); dropped > 0) {
+      loggers[UA_LOGCATEGORY_SERVER]->warning(
+          "Dropped {} log messages, since the log queue was full", dropped);
+    }
+  }
+
+  using SlotQueue = boost::lockfree::queue<uint16_t,
+      boost::lockfree::capacity<LOG_SLOTS>>;
+
+  array<LoggerPtr, LOG_CATEGORIES> loggers;
+  array<RateLimiter, LOG_CATEGORIES> limiters;
+  array<LogSlot, LOG_SLOTS> slots;
+  SlotQueue free_slots;
+  SlotQueue queued_slots;
+  atomic<uint64_t> dropped_messages = 0;
+  atomic<bool> running = true;
+  mutex wake_mx;
+  condition_variable wake;
+  thread drainer;
+};
 
 SeverityLevel getLoggingLevel(UA_LogLevel level) {
   switch (level) {
@@ -58,58 +172,74 @@ SeverityLevel getLoggingLevel(UA_LogLevel level) {
   }
 }
 
-LoggersMap* getLoggers(void* context_ptr) {
-  return static_cast<LoggersMap*>(context_ptr);
+LogBridge* getBridge(void* context_ptr) {
+  return static_cast<LogBridge*>(context_ptr);
+}
+
+void queueMessage(LogBridge* bridge, SeverityLevel severity, size_t category,
+    const char* msg, va_list args) {
+  uint16_t index = 0;
+  if (!bridge->free_slots.pop(index)) {
+    bridge->dropped_messages.fetch_add(1, memory_order_relaxed);
+    return;
+  }
+  auto& slot = bridge->slots[index];
+  slot.level = severity;
+  slot.category = category;
+  // clang-tidy bug for vsnprintf() @see
+  // https://bugs.llvm.org/show_bug.cgi?id=41311
+  // NOLINTNEXTLINE(clang-analyzer-valist.*, cert-err33-c, readability-*)
+  auto len = vsnprintf(slot.text.data(), slot.text.size(), msg, args);
+  // vsnprintf returns a negative value if an error occurred and the untruncated
+  // length otherwise
+  slot.length =
+      len < 0 ? 0 : min(static_cast<size_t>(len), slot.text.size() - 1);
+  // can not fail, since there are as many queue entries as slots
+  bridge->queued_slots.push(index);
+  bridge->wake.notify_one();
 }
 
 void logToHaSLL(void* context, UA_LogLevel level, UA_LogCategory category,
     const char* msg, va_list args) {
-  /*
-   * Kudos to Chris Dodd @stackoverflow
-   * https://stackoverflow.com/a/70749935
-   */
-  std::string message;
-  va_list args_copy;
-  va_copy(args_copy, args); // make a copy for the buffer size calculation
-  // NOLINTNEXTLINE(clang-analyzer-valist.*)
-  auto len = vsnprintf(
-      nullptr, 0, msg, args_copy); // get the amount of bytes needed to write
-  // vsnprintf returns a negative value if an error occurred
-  if (len > 0) {
-    auto padded_len = static_cast<size_t>(len) + 1;
-    message.resize(padded_len); // Add space for NULL terminator
-    // clang-tidy bug for vsnprintf() @see
-    // https://bugs.llvm.org/show_bug.cgi?id=41311
-    // NOLINTNEXTLINE(clang-analyzer-valist.*, cert-err33-c, readability-*)
-    vsnprintf(
-        message.data(), padded_len, msg, args); // write args into the message
-    message.resize(static_cast<size_t>(len)); // Remove the NULL terminator
-  } // else -> message will be empty
-
-  if (auto* loggers = getLoggers(context); loggers != nullptr) {
-    if (auto it = loggers->find(category); it != loggers->end()) {
-      it->second->log(getLoggingLevel(level), message);
-    }
+  auto severity = getLoggingLevel(level);
+  auto index = static_cast<size_t>(category);
+  auto* bridge = getBridge(context);
+  // filter before formatting anything
+  if (!isLogged(severity) || bridge == nullptr || index >= LOG_CATEGORIES ||
+      !bridge->loggers[index]) {
+    return;
+  }
+
+  auto now = chrono::duration_cast<chrono::nanoseconds>(
+      chrono::steady_clock::now().time_since_epoch())
+                 .count();
+  auto suppressed = bridge->limiters[index].acquire(now);
+  if (suppressed < 0) {
+    return;
+  }
+  if (suppressed > 0) {
+    bridge->loggers[index]->warning(
+        "Suppressed {} log messages, that exceeded the rate limit",
+        suppressed);
   }
+  queueMessage(bridge, severity, index, msg, args);
 }
 
 void destroyHaSLL(struct UA_Logger* logger) {
   if (logger != nullptr) {
-    if (auto* loggers = getLoggers(logger->context); loggers != nullptr) {
-      loggers->clear();
-      delete loggers;
-    }
+    // joins the drain thread, after it passed on all queued messages
+    delete getBridge(logger->context);
     UA_free(logger);
   }
 }
 } // namespace open62541
 
 UA_Logger* createHaSLL() {
-  auto* loggers = open62541::registerLoggers();
   auto* logger = (UA_Logger*)UA_malloc(sizeof(UA_Logger));
   if (logger == nullptr) {
     return nullptr;
   }
-  *logger = {open62541::logToHaSLL, loggers, open62541::destroyHaSLL};
+  *logger = {open62541::logToHaSLL, new open62541::LogBridge(),
+      open62541::destroyHaSLL};
   return logger;
-}
\ No newline at end of file
+}
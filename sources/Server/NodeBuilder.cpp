@@ -1,5 +1,6 @@
 #include "NodeBuilder.hpp"
 #include "CheckStatus.hpp"
+#include "LogFacade.hpp"
 #include "StringConverter.hpp"
 #include "VariantConverter.hpp"
 
@@ -8,7 +9,10 @@
 #include <open62541/nodeids.h>
 #include <open62541/statuscodes.h>
 
+#include <algorithm>
+#include <atomic>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace std;
@@ -18,6 +22,7 @@ using namespace open62541;
 
 constexpr UA_UInt16 SERVER_NAMESPACE = 1;
 
+namespace open62541 {
 struct NodeMetaInfo {
   NodeMetaInfo(const NodeMetaInfo& other) {
     UA_NodeId_copy(&(other.id), &id);
@@ -93,6 +98,61 @@ struct NodeMetaInfo {
   UA_QualifiedName name;
 };
 
+/**
+ * @brief Node of a device, that NodeBuilder::addDeviceNode() adds to the
+ * server
+ *
+ */
+struct PlannedNode {
+  PlannedNode(const MetaInfoPtr& meta, const ElementPtr& device_element,
+      const optional<UA_NodeId>& parent_node_id)
+      : meta_info(meta), element(device_element),
+        node(meta, parent_node_id) {}
+
+  MetaInfoPtr meta_info;
+  // nullptr for the device node itself
+  ElementPtr element;
+  NodeMetaInfo node;
+  optional<DataVariant> initial_value;
+#ifdef ENABLE_UA_HISTORIZING
+  // set once the node was added, if it is historized
+  const UA_DataType* history_type = nullptr;
+  bool sampled = true;
+#endif // ENABLE_UA_HISTORIZING
+};
+
+struct DevicePlan {
+  DevicePtr device;
+  deque<PlannedNode> nodes;
+};
+} // namespace open62541
+
+void planElement(const ElementPtr& element, const UA_NodeId& parent_id,
+    deque<PlannedNode>& plan) {
+  const auto& planned = plan.emplace_back(element, element, parent_id);
+  if (auto function = element->function();
+      holds_alternative<GroupPtr>(function)) {
+    get<GroupPtr>(function)->visit([&plan, &planned](const ElementPtr& child) {
+      planElement(child, planned.node.id, plan);
+    });
+  }
+}
+
+/**
+ * @brief Collect all nodes of the given device without touching the server,
+ * parents are placed before their children
+ *
+ */
+deque<PlannedNode> planDevice(const DevicePtr& device) {
+  deque<PlannedNode> plan;
+  // deque keeps the parent node ids in place, while children are added
+  const auto& root = plan.emplace_back(device, nullptr, nullopt);
+  device->visit([&plan, &root](const ElementPtr& element) {
+    planElement(element, root.node.id, plan);
+  });
+  return plan;
+}
+
 NodeBuilder::NodeBuilder(const CallbackRepoPtr& repo,
 #ifdef ENABLE_UA_HISTORIZING
     const HistorizerPtr& historizer,
@@ -107,181 +167,202 @@ NodeBuilder::NodeBuilder(const CallbackRepoPtr& repo,
 }
 
 #ifdef ENABLE_UA_HISTORIZING
-void NodeBuilder::historize(UA_NodeId node_id, const UA_DataType* type) {
+UA_StatusCode NodeBuilder::historize(const deque<PlannedNode>& plan) {
   if (!historizer_) {
     logger_->info("Historizer is not set");
-    return;
+    return UA_STATUSCODE_GOOD;
   }
-  try {
-    auto status = historizer_->registerNodeId(server_, node_id, type);
-    checkStatusCode(
-        "While registering writable node historization callback", status);
-  } catch (const StatusCodeNotGood& ex) {
-    logger_->error("Failed to historize node {} due to exception {}",
-        toString(&node_id), ex.what());
+  vector<NodeRegistration> registrations;
+  for (const auto& planned : plan) {
+    if (planned.history_type != nullptr) {
+      registrations.push_back(
+          NodeRegistration{planned.node.id, planned.history_type,
+              planned.sampled});
+    }
+  }
+  if (registrations.empty()) {
+    return UA_STATUSCODE_GOOD;
   }
+  auto status = historizer_->registerNodeIds(server_, registrations);
+  if (status != UA_STATUSCODE_GOOD) {
+    logger_->error("Failed to historize nodes of device {}. Status: {}",
+        toString(&plan.front().node.id), UA_StatusCode_name(status));
+  }
+  return status;
 }
 #endif // ENABLE_UA_HISTORIZING
 
-UA_NodeId NodeBuilder::addObjectNode(
-    const MetaInfoPtr& element, const optional<UA_NodeId>& parent_node_id) {
+/**
+ * @brief Joins the given threads, once it goes out of scope, destroying a
+ * joinable thread would call std::terminate
+ *
+ */
+struct JoinThreads {
+  explicit JoinThreads(vector<thread>* threads) : threads_(threads) {}
+
+  ~JoinThreads() {
+    for (auto& joined : *threads_) {
+      if (joined.joinable()) {
+        joined.join();
+      }
+    }
+  }
+
+  JoinThreads(const JoinThreads&) = delete;
+  JoinThreads& operator=(const JoinThreads&) = delete;
+
+private:
+  vector<thread>* threads_;
+};
+
+void NodeBuilder::readInitialValues(deque<PlannedNode>& plan) const {
+  // only observables keep their value in the node, data source nodes read
+  // the device on demand
+  vector<pair<PlannedNode*, ObservablePtr>> pending;
+  for (auto& planned : plan) {
+    if (!planned.element) {
+      continue;
+    }
+    auto function = planned.element->function();
+    if (auto* observable = get_if<ObservablePtr>(&function)) {
+      pending.emplace_back(&planned, *observable);
+    }
+  }
+
+  atomic<size_t> next = 0;
+  auto reader = [this, &pending, &next]() {
+    for (auto i = next++; i < pending.size(); i = next++) {
+      auto& [planned, observable] = pending[i];
+      try {
+        planned->initial_value = observable->read();
+      } catch (const exception& ex) {
+        logger_->warning("Failed to read initial value of {}. Exception: {}",
+            planned->meta_info->id(), ex.what());
+      }
+    }
+  };
+  auto count = min<size_t>(
+      pending.size(), max<size_t>(thread::hardware_concurrency(), 1));
+  vector<thread> readers;
+  // started readers are joined, even if starting the next one throws
+  JoinThreads join_readers(&readers);
+  for (size_t i = 1; i < count; ++i) {
+    readers.emplace_back(reader);
+  }
+  reader();
+}
+
+UA_StatusCode NodeBuilder::addObjectNode(const PlannedNode& planned) {
+  const auto& element = planned.meta_info;
+  const auto& node = planned.node;
   logger_->info(
       "Adding a new node: {}, with id: {}", element->name(), element->id());
 
   auto type_definition = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE);
 
-  auto node = NodeMetaInfo(element, parent_node_id);
   auto object_attributes = UA_ObjectAttributes_default;
   object_attributes.displayName =
       UA_LOCALIZEDTEXT_ALLOC("EN_US", element->name().c_str());
   object_attributes.description =
       UA_LOCALIZEDTEXT_ALLOC("EN_US", element->description().c_str());
 
-  UA_NodeId result;
   auto status = UA_Server_addObjectNode(server_, node.id, node.parent,
       node.reference_type, node.name, type_definition, object_attributes,
-      nullptr, &result);
-
-  checkStatusCode(
-      "While creating Object Node for " + element->id() + " " + element->name(),
-      status);
-
+      nullptr, nullptr);
   UA_ObjectAttributes_clear(&object_attributes);
 
-  return result;
+  if (status != UA_STATUSCODE_GOOD) {
+    logger_->error("Failed to create Object Node for {}:{}. Status: {}",
+        element->id(), element->name(), UA_StatusCode_name(status));
+  }
+  return status;
+}
+
+DevicePlanPtr NodeBuilder::prepareDeviceNode(const DevicePtr& device) const {
+  auto plan = make_shared<DevicePlan>();
+  plan->device = device;
+  plan->nodes = planDevice(device);
+  readInitialValues(plan->nodes);
+  return plan;
 }
 
 UA_StatusCode NodeBuilder::addDeviceNode(const DevicePtr& device) {
-  try {
-    auto parent_id = addObjectNode(device);
-    device->visit([this, parent_id](const ElementPtr& element) {
-      try {
-        auto status = addElementNode(element, parent_id);
-        checkStatusCode("While adding DeviceElement " + element->id() + " " +
-                element->name() + " node",
-            status);
-
-      } catch (const StatusCodeNotGood& ex) {
-        logger_->error("Failed to create an Element Node {}:{} for Device Node "
-                       "{}. Status: {}",
-            element->id(), element->name(), toString(&parent_id), ex.what());
-      }
-    });
-    UA_NodeId_clear(&parent_id);
-    return UA_STATUSCODE_GOOD;
-  } catch (const StatusCodeNotGood& ex) {
-    logger_->error("Failed to create a Node for Device {}:{}. Status: {}",
-        device->id(), device->name(), ex.what());
-    return UA_STATUSCODE_BADINTERNALERROR;
-  }
+  return addDeviceNode(prepareDeviceNode(device));
 }
 
-UA_StatusCode NodeBuilder::removeDataSources(const UA_NodeId* node_id) {
-  UA_StatusCode result = UA_STATUSCODE_BAD;
-  UA_BrowseDescription browse_description{// clang-format off
-      .nodeId = *node_id,
-      .browseDirection = UA_BROWSEDIRECTION_FORWARD,
-      .referenceTypeId = UA_NODEID_NULL,
-      .includeSubtypes = UA_TRUE,
-      .nodeClassMask = UA_NODECLASS_OBJECT | UA_NODECLASS_VARIABLE | UA_NODECLASS_METHOD,
-      .resultMask = UA_BROWSERESULTMASK_NODECLASS
-  }; // clang-format on
-
-  logger_->trace(
-      "Browsing Node {} for subnodes with callbacks", toString(node_id));
-  auto browse_result = UA_Server_browse(server_, 0, &browse_description);
-
-  for (size_t i = 0; i < browse_result.referencesSize; ++i) {
-    auto node_reference = browse_result.references[i];
-    if (node_reference.nodeClass != UA_NODECLASS_OBJECT) {
-      repo_->remove(&node_reference.nodeId.nodeId);
-      result = UA_STATUSCODE_GOOD;
-    } else {
-      result = removeDataSources(&node_reference.nodeId.nodeId);
+UA_StatusCode NodeBuilder::addDeviceNode(const DevicePlanPtr& plan) {
+  const auto& device = plan->device;
+  for (size_t i = 0; i < plan->nodes.size(); ++i) {
+    auto status = addPlannedNode(plan->nodes[i], device->id());
+    if (status != UA_STATUSCODE_GOOD) {
+      logger_->error("Failed to create a Node for Device {}:{}, removing its "
+                     "{} created nodes. Status: {}",
+          device->id(), device->name(), i, UA_StatusCode_name(status));
+      // a failed device node may belong to an other device with the same id
+      if (i > 0) {
+        deleteDeviceNode(device->id());
+      }
+      return status;
     }
   }
-
-  UA_BrowseResult_clear(&browse_result);
-  return result;
+#ifdef ENABLE_UA_HISTORIZING
+  auto status = historize(plan->nodes);
+  if (status != UA_STATUSCODE_GOOD) {
+    logger_->error("Failed to historize Device {}:{}, removing its nodes",
+        device->id(), device->name());
+    deleteDeviceNode(device->id());
+    return status;
+  }
+#endif // ENABLE_UA_HISTORIZING
+  return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode NodeBuilder::deleteDeviceNode(const string& device_id) {
   auto device_node_id =
       UA_NODEID_STRING_ALLOC(SERVER_NAMESPACE, device_id.c_str());
-  logger_->trace("Removing Node {}", toString(&device_node_id));
+  OPEN62541_TRACE(logger_, "Removing Node {}", toString(&device_node_id));
 
-  auto result = removeDataSources(&device_node_id);
+  auto removed = repo_->removeDevice(device_id);
+  OPEN62541_TRACE(logger_,
+      "Removed {} linked data sources for device node {}", removed, device_id);
 
-  if (UA_StatusCode_isBad(result)) {
-    logger_->error(
-        "Could not remove data sources for {} device node", device_id);
-  } else {
-    logger_->trace("Removed linked data sources for device node {}", device_id);
-  }
-
-  result = UA_Server_deleteNode(server_, device_node_id, true);
+  auto result = UA_Server_deleteNode(server_, device_node_id, true);
   if (UA_StatusCode_isBad(result)) {
     logger_->error("Could not delete {} device node: {}", device_id,
         string(UA_StatusCode_name(result)));
   } else {
-    logger_->trace("Device node {} deleted", device_id);
+    OPEN62541_TRACE(logger_, "Device node {} deleted", device_id);
   }
 
   UA_NodeId_clear(&device_node_id);
   return result;
 }
 
-UA_StatusCode NodeBuilder::addElementNode(
-    const ElementPtr& element, const UA_NodeId& parent_id) {
-  logger_->info(
-      "Adding element {} to node {}", element->name(), toString(&parent_id));
+UA_StatusCode NodeBuilder::addPlannedNode(
+    PlannedNode& planned, const string& device_id) {
+  if (!planned.element) {
+    return addObjectNode(planned);
+  }
+  logger_->info("Adding element {} to node {}", planned.meta_info->name(),
+      toString(&planned.node.parent));
 
   return Variant_Visitor::match(
-      element->function(),
-      [&](const GroupPtr& group) {
-        return addGroupNode(element, group, parent_id);
-      },
+      planned.element->function(),
+      [&](const GroupPtr& /*group*/) { return addObjectNode(planned); },
       [&](const ObservablePtr& observable) {
-        return addObservableNode(element, observable, parent_id);
+        return addObservableNode(planned, observable, device_id);
       },
       [&](const ReadablePtr& readable) {
-        return addReadableNode(element, readable, parent_id);
+        return addReadableNode(planned, readable, device_id);
       },
       [&](const WritablePtr& writable) {
-        return addWritableNode(element, writable, parent_id);
+        return addWritableNode(planned, writable, device_id);
       },
       [&](const CallablePtr& callable) {
-        return addCallableNode(element, callable, parent_id);
+        return addCallableNode(planned, callable, device_id);
       });
 }
 
-UA_StatusCode NodeBuilder::addGroupNode(const MetaInfoPtr& meta_info,
-    const GroupPtr& group, const UA_NodeId& parent_id) {
-  logger_->trace("Adding Group Node for element {}:{}", meta_info->id(),
-      meta_info->name());
-  try {
-    auto node_id = addObjectNode(meta_info, parent_id);
-    group->visit([this, node_id](const ElementPtr& element) {
-      try {
-        auto status = addElementNode(element, node_id);
-        checkStatusCode("While adding DeviceElement " + element->id() + " " +
-                element->name() + " node",
-            status);
-      } catch (const StatusCodeNotGood& ex) {
-        logger_->error(
-            "Failed to create element {}:{} for parent node {}. Status: {}",
-            element->id(), element->name(), toString(&node_id), ex.what());
-      }
-    });
-    UA_NodeId_clear(&node_id);
-    return UA_STATUSCODE_GOOD;
-  } catch (const StatusCodeNotGood& ex) {
-    logger_->error("Failed to create a Node for Group {}:{}. Status: {}",
-        meta_info->id(), meta_info->name(), ex.what());
-    return UA_STATUSCODE_BADINTERNALERROR;
-  }
-}
-
 UA_VariableAttributes setValueAttributes(const MetaInfoPtr& meta_info,
     DataType type, const optional<DataVariant>& value = nullopt) {
   UA_VariableAttributes value_attributes = UA_VariableAttributes_default;
@@ -290,6 +371,8 @@ UA_VariableAttributes setValueAttributes(const MetaInfoPtr& meta_info,
   value_attributes.displayName =
       UA_LOCALIZEDTEXT_ALLOC("EN_US", meta_info->name().c_str());
   value_attributes.dataType = toNodeId(type);
+  // Information Model values are scalars, the server rejects array writes
+  value_attributes.valueRank = UA_VALUERANK_SCALAR;
 
   // this will always have a value, since toNodeId() throws if type is not
   // supported
@@ -298,34 +381,26 @@ UA_VariableAttributes setValueAttributes(const MetaInfoPtr& meta_info,
 
   // open62541 seems to require some default value set, even if the node is
   // write-only
-  auto ua_variant = toUAVariant(default_value);
-  // Copy the value into the attributes, to avoid memory leaks
-  UA_Variant_setScalarCopy(
-      &value_attributes.value, &ua_variant, ua_variant.type);
-  UA_Variant_clear(&ua_variant);
-  return value_attributes;
-}
-
-UA_VariableAttributes setValueAttributes(
-    const MetaInfoPtr& meta_info, const DataVariant& value, DataType type) {
-  auto value_attributes = setValueAttributes(meta_info, type, value);
+  toUAVariant(default_value, &value_attributes.value);
   return value_attributes;
 }
 
-UA_StatusCode NodeBuilder::addReadableNode(const MetaInfoPtr& meta_info,
-    const ReadablePtr& readable, const UA_NodeId& parent_id) {
-  logger_->trace("Adding Readable Node for element {}:{}", meta_info->id(),
-      meta_info->name());
-  auto node = NodeMetaInfo(meta_info, parent_id);
+UA_StatusCode NodeBuilder::addReadableNode(PlannedNode& planned,
+    const ReadablePtr& readable, const string& device_id) {
+  const auto& meta_info = planned.meta_info;
+  const auto& node = planned.node;
+  OPEN62541_TRACE(logger_, "Adding Readable Node for element {}:{}",
+      meta_info->id(), meta_info->name());
   try {
-    auto value_attributes =
-        setValueAttributes(meta_info, readable->read(), readable->dataType());
+    // the data source reads the device on demand, so the attribute value only
+    // needs the data type
+    auto value_attributes = setValueAttributes(meta_info, readable->dataType());
     value_attributes.accessLevel = UA_ACCESSLEVELMASK_READ;
 #ifdef ENABLE_UA_HISTORIZING
     value_attributes.accessLevel |= UA_ACCESSLEVELMASK_HISTORYREAD;
     value_attributes.historizing = true;
 #endif // ENABLE_UA_HISTORIZING
-    auto status = repo_->add(node.id, readable);
+    auto status = repo_->add(node.id, readable, device_id);
     checkStatusCode("While setting readable metric callbacks", status);
 
     UA_DataSource data_source;
@@ -336,9 +411,9 @@ UA_StatusCode NodeBuilder::addReadableNode(const MetaInfoPtr& meta_info,
         UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE);
     status = UA_Server_addDataSourceVariableNode(server_, node.id, node.parent,
         node.reference_type, node.name, type_definition, value_attributes,
-        data_source, repo_.get(), nullptr);
+        data_source, repo_->nodeContext(node.id), nullptr);
 #ifdef ENABLE_UA_HISTORIZING
-    historize(node.id, value_attributes.value.type);
+    planned.history_type = value_attributes.value.type;
 #endif // ENABLE_UA_HISTORIZING
     UA_NodeId_clear(&type_definition);
     UA_VariableAttributes_clear(&value_attributes);
@@ -353,39 +428,44 @@ UA_StatusCode NodeBuilder::addReadableNode(const MetaInfoPtr& meta_info,
   }
 }
 
-UA_StatusCode NodeBuilder::addObservableNode(
-    const Information_Model::MetaInfoPtr& meta_info,
+UA_StatusCode NodeBuilder::addObservableNode(PlannedNode& planned,
     const Information_Model::ObservablePtr& observable,
-    const UA_NodeId& parent_id) {
-  logger_->trace("Adding Observable Node for element {}:{}", meta_info->id(),
-      meta_info->name());
-  auto node = NodeMetaInfo(meta_info, parent_id);
+    const string& device_id) {
+  const auto& meta_info = planned.meta_info;
+  const auto& node = planned.node;
+  OPEN62541_TRACE(logger_, "Adding Observable Node for element {}:{}",
+      meta_info->id(), meta_info->name());
   try {
-    auto status = repo_->add(node.id, observable);
+    auto status = repo_->add(node.id, observable, device_id);
     checkStatusCode("While setting readable metric callbacks", status);
 
+    // initial value was read by readInitialValues()
     auto value_attributes = setValueAttributes(
-        meta_info, observable->read(), observable->dataType());
+        meta_info, observable->dataType(), planned.initial_value);
     value_attributes.accessLevel = UA_ACCESSLEVELMASK_READ;
 #ifdef ENABLE_UA_HISTORIZING
     value_attributes.accessLevel |= UA_ACCESSLEVELMASK_HISTORYREAD;
     value_attributes.historizing = true;
 #endif // ENABLE_UA_HISTORIZING
-    UA_DataSource data_source;
-    data_source.read = &readNodeValue;
-    data_source.write = nullptr;
-
+    // observed values are written into the node, instead of reading them
+    // from the device on every client read or monitored item sample
     UA_NodeId type_definition =
         UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE);
-    status = UA_Server_addDataSourceVariableNode(server_, node.id, node.parent,
+    status = UA_Server_addVariableNode(server_, node.id, node.parent,
         node.reference_type, node.name, type_definition, value_attributes,
-        data_source, repo_.get(), nullptr);
+        repo_->nodeContext(node.id), nullptr);
 #ifdef ENABLE_UA_HISTORIZING
-    historize(node.id, value_attributes.value.type);
+    if (status == UA_STATUSCODE_GOOD) {
+      // written values are passed to the Historizer by the server
+      planned.history_type = value_attributes.value.type;
+      planned.sampled = false;
+    }
 #endif // ENABLE_UA_HISTORIZING
     UA_NodeId_clear(&type_definition);
     UA_VariableAttributes_clear(&value_attributes);
-    checkStatusCode("While adding readable variable node to server", status);
+    checkStatusCode("While adding observable variable node to server", status);
+    status = repo_->observe(server_, &node.id);
+    checkStatusCode("While subscribing to observable notifications", status);
     return status;
   } catch (const StatusCodeNotGood& ex) {
     logger_->error(
@@ -396,13 +476,14 @@ UA_StatusCode NodeBuilder::addObservableNode(
   }
 }
 
-UA_StatusCode NodeBuilder::addWritableNode(const MetaInfoPtr& meta_info,
-    const WritablePtr& writable, const UA_NodeId& parent_id) {
-  logger_->trace("Adding Writable Node for element {}:{}", meta_info->id(),
-      meta_info->name());
-  auto node = NodeMetaInfo(meta_info, parent_id);
+UA_StatusCode NodeBuilder::addWritableNode(PlannedNode& planned,
+    const WritablePtr& writable, const string& device_id) {
+  const auto& meta_info = planned.meta_info;
+  const auto& node = planned.node;
+  OPEN62541_TRACE(logger_, "Adding Writable Node for element {}:{}",
+      meta_info->id(), meta_info->name());
   try {
-    auto status = repo_->add(node.id, writable);
+    auto status = repo_->add(node.id, writable, device_id);
     checkStatusCode("While setting writable metric callbacks", status);
 
     auto value_attributes = setValueAttributes(meta_info, writable->dataType());
@@ -411,7 +492,6 @@ UA_StatusCode NodeBuilder::addWritableNode(const MetaInfoPtr& meta_info,
         UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
     UA_DataSource data_source;
     if (!writable->isWriteOnly()) {
-      value_attributes.value = toUAVariant(writable->read());
 #ifdef ENABLE_UA_HISTORIZING
       value_attributes.accessLevel |= UA_ACCESSLEVELMASK_HISTORYREAD;
       value_attributes.historizing = true;
@@ -424,9 +504,9 @@ UA_StatusCode NodeBuilder::addWritableNode(const MetaInfoPtr& meta_info,
         UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE);
     status = UA_Server_addDataSourceVariableNode(server_, node.id, node.parent,
         node.reference_type, node.name, type_definition, value_attributes,
-        data_source, repo_.get(), nullptr);
+        data_source, repo_->nodeContext(node.id), nullptr);
 #ifdef ENABLE_UA_HISTORIZING
-    historize(node.id, value_attributes.value.type);
+    planned.history_type = value_attributes.value.type;
 #endif // ENABLE_UA_HISTORIZING
     UA_NodeId_clear(&type_definition);
     UA_VariableAttributes_clear(&value_attributes);
@@ -473,17 +553,18 @@ UA_Argument* makeOutputType(DataType type) {
   return result;
 }
 
-UA_StatusCode NodeBuilder::addCallableNode(const MetaInfoPtr& meta_info,
-    const CallablePtr& callable, const UA_NodeId& parent_id) {
-  logger_->trace("Adding Callable Node for element {}:{}", meta_info->id(),
-      meta_info->name());
+UA_StatusCode NodeBuilder::addCallableNode(const PlannedNode& planned,
+    const CallablePtr& callable, const string& device_id) {
+  const auto& meta_info = planned.meta_info;
+  const auto& node = planned.node;
+  OPEN62541_TRACE(logger_, "Adding Callable Node for element {}:{}",
+      meta_info->id(), meta_info->name());
   auto status = UA_STATUSCODE_BADINTERNALERROR;
   auto* input_args = makeInputArgs(callable->parameterTypes());
   auto* output = makeOutputType(callable->resultType());
-  auto node = NodeMetaInfo(meta_info, parent_id);
   auto method_attributes = UA_MethodAttributes_default;
   try {
-    status = repo_->add(node.id, callable);
+    status = repo_->add(node.id, callable, device_id);
     checkStatusCode("While setting executable callbacks", status);
 
     method_attributes.description =
@@ -496,8 +577,13 @@ UA_StatusCode NodeBuilder::addCallableNode(const MetaInfoPtr& meta_info,
     status = UA_Server_addMethodNode(server_, node.id, node.parent,
         node.reference_type, node.name, method_attributes, &callNodeMethod,
         callable->parameterTypes().size(), input_args,
-        output == nullptr ? 0 : 1, output, repo_.get(), nullptr);
+        output == nullptr ? 0 : 1, output, repo_->nodeContext(node.id),
+        nullptr);
     checkStatusCode("While adding method node to server", status);
+    // calls are queued and executed by the Runner method workers, so long
+    // running device commands do not block the server thread
+    status = UA_Server_setMethodNodeAsync(server_, node.id, true);
+    checkStatusCode("While marking method node as async", status);
   } catch (const StatusCodeNotGood& ex) {
     logger_->error(
         "Failed to create a Node for Callable element {}:{}. Status: {}",
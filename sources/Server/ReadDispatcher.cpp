@@ -0,0 +1,81 @@
+#include "ReadDispatcher.hpp"
+#include "LogFacade.hpp"
+
+#include <HaSLL/LoggerManager.hpp>
+
+namespace open62541 {
+using namespace std;
+using namespace HaSLL;
+using namespace Information_Model;
+
+ReadDispatcher::ReadDispatcher(const ReadDispatcherConfig& config)
+    : config_(config),
+      logger_(LoggerManager::registerLogger("Open62541::ReadDispatcher")) {
+  for (const auto& rule : config_.rules) {
+    patterns_.emplace_back(rule.pattern);
+  }
+  workers_.reserve(config_.workers);
+  for (size_t i = 0; i < config_.workers; ++i) {
+    workers_.emplace_back(&ReadDispatcher::run, this);
+  }
+  OPEN62541_TRACE(logger_, "Started {} read workers", workers_.size());
+}
+
+ReadDispatcher::~ReadDispatcher() {
+  {
+    lock_guard lock(queue_mx_);
+    running_ = false;
+  }
+  queued_.notify_all();
+  for (auto& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+ReadLimits ReadDispatcher::limits(const string& node_id) const {
+  for (size_t i = 0; i < patterns_.size(); ++i) {
+    if (regex_match(node_id, patterns_[i])) {
+      return config_.rules[i].limits;
+    }
+  }
+  return config_.defaults;
+}
+
+future<DataVariant> ReadDispatcher::dispatch(Reader&& reader) {
+  packaged_task<DataVariant()> task(move(reader));
+  auto result = task.get_future();
+  if (workers_.empty()) {
+    task();
+    return result;
+  }
+  {
+    lock_guard lock(queue_mx_);
+    if (queue_.size() >= config_.queue_capacity) {
+      throw ReadQueueFull();
+    }
+    queue_.push_back(move(task));
+  }
+  queued_.notify_one();
+  return result;
+}
+
+void ReadDispatcher::run() {
+  while (true) {
+    packaged_task<DataVariant()> task;
+    {
+      unique_lock lock(queue_mx_);
+      queued_.wait(lock, [this]() { return !running_ || !queue_.empty(); });
+      if (!running_) {
+        // abandoned reads report a broken promise to their waiters
+        return;
+      }
+      task = move(queue_.front());
+      queue_.pop_front();
+    }
+    // exceptions are stored in the future and rethrown by the waiting reader
+    task();
+  }
+}
+} // namespace open62541
@@ -0,0 +1,127 @@
+#include "RegistrationPipeline.hpp"
+#include "LogFacade.hpp"
+
+#include <HaSLL/LoggerManager.hpp>
+
+#include <algorithm>
+
+namespace open62541 {
+using namespace std;
+using namespace HaSLL;
+using namespace Information_Model;
+
+RegistrationPipeline::RegistrationPipeline(
+    const shared_ptr<NodeBuilder>& builder, const RegistrationConfig& config)
+    : logger_(LoggerManager::registerLogger("Open62541::Registration")),
+      builder_(builder), config_(config) {
+  config_.queue_capacity = max<size_t>(config_.queue_capacity, 1);
+  workers_.reserve(config_.workers);
+  for (size_t i = 0; i < config_.workers; ++i) {
+    workers_.emplace_back(&RegistrationPipeline::run, this);
+  }
+  OPEN62541_TRACE(logger_, "Started {} registration workers", workers_.size());
+}
+
+RegistrationPipeline::~RegistrationPipeline() {
+  {
+    lock_guard lock(queue_mx_);
+    running_ = false;
+  }
+  changed_.notify_all();
+  for (auto& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+void RegistrationPipeline::add(const DevicePtr& device) {
+  auto event = make_shared<Event>();
+  event->device = device;
+  event->device_id = device->id();
+  queue(move(event));
+}
+
+void RegistrationPipeline::remove(const string& device_id) {
+  auto event = make_shared<Event>();
+  event->device_id = device_id;
+  // deregistrations have nothing to prepare, marking them as taken keeps
+  // idle workers from preparing an event without a device
+  event->taken = true;
+  event->prepared = true;
+  queue(move(event));
+}
+
+void RegistrationPipeline::queue(EventPtr&& event) {
+  if (workers_.empty()) {
+    if (event->device) {
+      prepare(*event);
+    }
+    apply(*event);
+    return;
+  }
+  {
+    unique_lock lock(queue_mx_);
+    changed_.wait(
+        lock, [this]() { return queue_.size() < config_.queue_capacity; });
+    queue_.push_back(move(event));
+  }
+  changed_.notify_all();
+}
+
+void RegistrationPipeline::run() {
+  unique_lock lock(queue_mx_);
+  while (true) {
+    auto next = find_if(queue_.begin(), queue_.end(),
+        [](const EventPtr& event) { return !event->taken; });
+    if (!applying_ && !queue_.empty() && queue_.front()->prepared) {
+      // events are applied strictly in queue order, so a deregistration
+      // can not overtake the registration of the same device
+      auto event = move(queue_.front());
+      queue_.pop_front();
+      applying_ = true;
+      lock.unlock();
+      changed_.notify_all();
+      apply(*event);
+      lock.lock();
+      applying_ = false;
+      changed_.notify_all();
+    } else if (next != queue_.end()) {
+      auto event = *next;
+      event->taken = true;
+      lock.unlock();
+      prepare(*event);
+      lock.lock();
+      event->prepared = true;
+      changed_.notify_all();
+    } else if (!running_ && queue_.empty()) {
+      return;
+    } else {
+      changed_.wait(lock);
+    }
+  }
+}
+
+void RegistrationPipeline::prepare(Event& event) {
+  try {
+    event.plan = builder_->prepareDeviceNode(event.device);
+  } catch (const exception& ex) {
+    logger_->error("Failed to prepare nodes for Device {}. Exception: {}",
+        event.device_id, ex.what());
+  }
+}
+
+void RegistrationPipeline::apply(const Event& event) {
+  try {
+    if (!event.device) {
+      builder_->deleteDeviceNode(event.device_id);
+    } else if (event.plan) {
+      builder_->addDeviceNode(event.plan);
+    }
+  } catch (const exception& ex) {
+    logger_->error("Failed to apply registration event for Device {}. "
+                   "Exception: {}",
+        event.device_id, ex.what());
+  }
+}
+} // namespace open62541
@@ -1,30 +1,54 @@
 #include "Runner.hpp"
+#include "LogFacade.hpp"
 
 #include <HaSLL/LoggerManager.hpp>
 
+#include <algorithm>
+#include <chrono>
+
 namespace open62541 {
 using namespace std;
 using namespace HaSLL;
 using namespace Information_Model;
 
-Runner::Runner(UA_ServerConfig* config)
-    : logger_(LoggerManager::registerLogger("Open62541::Runner")) {
+// open62541 notifies new async operations without a context pointer, so the
+// workers poll the queue instead
+constexpr auto ASYNC_POLL_INTERVAL = chrono::milliseconds(10);
+
+Runner::Runner(UA_ServerConfig* config, const RunnerConfig& runner_config)
+    : config_(runner_config),
+      logger_(LoggerManager::registerLogger("Open62541::Runner")) {
   server_ = UA_Server_newWithConfig(config);
 }
 
-Runner::~Runner() { UA_Server_delete(server_); }
+Runner::~Runner() {
+  // workers use the server, so they are stopped before it is deleted
+  stop();
+  UA_Server_delete(server_);
+}
 
 bool Runner::start() {
   try {
     logger_->info("Starting open62541 server!");
-    if (isRunning()) {
+    // joins the threads of a previous run, even if it failed to start up
+    stop();
+    running_ = true;
+    promise<UA_StatusCode> startup;
+    auto started = startup.get_future();
+    thread_ = thread(&Runner::runnable, this, move(startup));
+    if (started.get() != UA_STATUSCODE_GOOD) {
       stop();
+      return false;
+    }
+    if (config_.mode == RunnerMode::WORKER_POOL) {
+      auto count = max<size_t>(config_.workers, 1);
+      for (size_t i = 0; i < count; ++i) {
+        workers_.emplace_back(&Runner::processAsyncOperations, this);
+      }
     }
-    running_ = true;
-    thread_ = thread(&Runner::runnable, this);
 
     if (thread_.joinable()) {
-      logger_->trace("Open62541 server thread is running!");
+      OPEN62541_TRACE(logger_, "Open62541 server thread is running!");
       return true;
     } else {
       logger_->error("Could not start Open62541 server thread!");
@@ -33,37 +57,101 @@ bool Runner::start() {
   } catch (const exception& ex) {
     logger_->critical(
         "Caught an exception while starting the server: {}", ex.what());
+    // joins the threads, that were started before the exception
+    stop();
     return false;
   }
 }
 
 bool Runner::stop() {
-  if (isRunning()) {
+  if (running_.exchange(false)) {
     logger_->info("Stopping open62541 server!");
-    running_ = false;
+  }
+  {
+    // the workers check running_ under this lock before they wait
+    lock_guard lock(workers_mx_);
+  }
+  workers_wake_.notify_all();
+  // the server thread also ends on its own, if the server fails to start up
+  if (thread_.joinable()) {
     thread_.join();
-    logger_->trace("Joined open62541 server thread!");
+    OPEN62541_TRACE(logger_, "Joined open62541 server thread!");
+  }
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+  if (!workers_.empty()) {
+    workers_.clear();
+    OPEN62541_TRACE(logger_, "Joined open62541 worker threads!");
   }
   return true;
 }
 
-void Runner::runnable() {
-  do {
+void Runner::runnable(promise<UA_StatusCode> startup) {
+  logger_->info("Starting open62541 server thread");
+  auto status = UA_Server_run_startup(server_);
+  if (status != UA_STATUSCODE_GOOD) {
+    logger_->error("ERROR:{} Failed to start open62541 server thread!",
+        UA_StatusCode_name(status));
+    running_ = false;
+    startup.set_value(status);
+    return;
+  }
+  startup.set_value(status);
+  while (isRunning()) {
     try {
-      logger_->info("Starting open62541 server thread");
-      auto status = UA_Server_run(server_, &running_);
-      if (status != UA_STATUSCODE_GOOD) {
-        logger_->error("ERROR:{} Failed to start open62541 server thread!",
-            UA_StatusCode_name(status));
+      // waits for network events or the next timed callback
+      UA_Server_run_iterate(server_, true);
+      if (config_.mode == RunnerMode::SINGLE_THREAD) {
+        while (processAsyncOperation()) {
+        }
       }
     } catch (const exception& ex) {
       logger_->critical(
           "Caught an exception during server lifetime: {}", ex.what());
     }
-  } while (isRunning());
+  }
+  status = UA_Server_run_shutdown(server_);
+  if (status != UA_STATUSCODE_GOOD) {
+    logger_->error("ERROR:{} Failed to shut down open62541 server!",
+        UA_StatusCode_name(status));
+  }
+}
+
+void Runner::processAsyncOperations() {
+  while (isRunning()) {
+    if (!processAsyncOperation()) {
+      unique_lock lock(workers_mx_);
+      workers_wake_.wait_for(
+          lock, ASYNC_POLL_INTERVAL, [this]() { return !isRunning(); });
+    }
+  }
+}
+
+bool Runner::processAsyncOperation() {
+  UA_AsyncOperationType type;
+  const UA_AsyncOperationRequest* request = nullptr;
+  void* context = nullptr;
+  UA_DateTime timeout = 0;
+  if (!UA_Server_getAsyncOperationNonBlocking(
+          server_, &type, &request, &context, &timeout)) {
+    return false;
+  }
+  if (type != UA_ASYNCOPERATIONTYPE_CALL) {
+    logger_->warning("Ignoring unsupported async operation");
+    return true;
+  }
+  // calls the method callback of the node on this thread, the server
+  // answers with BadTimeout, if the result arrives after the timeout
+  UA_AsyncOperationResponse response;
+  response.callMethodResult =
+      UA_Server_call(server_, &request->callMethodRequest);
+  UA_Server_setAsyncOperationResult(server_, &response, context);
+  UA_CallMethodResult_clear(&response.callMethodResult);
+  return true;
 }
 
 UA_Server* Runner::getServer() { return server_; }
 
-bool Runner::isRunning() const { return running_; }
+bool Runner::isRunning() const { return running_.load(); }
 } // namespace open62541
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "StringConverter.hpp"
+#include "TypeRegistry.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstdio>
 #include <stdexcept>
 
 namespace open62541 {
@@ -32,13 +36,18 @@ string toString(const UA_ExpandedNodeId& id) {
 
 string toString(UA_DateTime timestamp) {
   auto calendar_time = UA_DateTime_toStruct(timestamp);
-  /* Format UA_DateTime into a %Y-%m-%d %H:%M:%S.%ms%us*/
-  auto result = to_string(calendar_time.year) + "-" +
-      to_string(calendar_time.month) + "-" + to_string(calendar_time.day) +
-      " " + to_string(calendar_time.hour) + ":" + to_string(calendar_time.min) +
-      ":" + to_string(calendar_time.sec) + "." +
-      to_string(calendar_time.milliSec) + to_string(calendar_time.microSec);
-  return result;
+  // "YYYY-MM-DD hh:mm:ss.uuuuuu" and the terminating null
+  array<char, 27> buffer{}; // NOLINT(readability-magic-numbers)
+  /* Format UA_DateTime into a %Y-%m-%d %H:%M:%S.%ms%us, milli and micro
+   * seconds are zero padded, so they form a single fraction*/
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg, cert-err33-c)
+  auto length = snprintf(buffer.data(), buffer.size(),
+      "%04d-%02d-%02d %02d:%02d:%02d.%03d%03d", calendar_time.year,
+      calendar_time.month, calendar_time.day, calendar_time.hour,
+      calendar_time.min, calendar_time.sec, calendar_time.milliSec,
+      calendar_time.microSec);
+  return string(buffer.data(),
+      min(static_cast<size_t>(max(length, 0)), buffer.size() - 1));
 }
 
 UA_String makeUAString(const string& input) {
@@ -58,61 +67,12 @@ UA_ByteString makeUAByteString(const vector<uint8_t>& input) {
 }
 
 string toSqlType(const UA_DataType* variant) {
-  switch (variant->typeKind) {
-  case UA_DataTypeKind::UA_DATATYPEKIND_BOOLEAN: {
-    return "BOOLEAN";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_BYTE: {
-    return "OPCUA_TINYUINT";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_SBYTE: {
-    return "OPCUA_TINYINT";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT16: {
-    return "OPCUA_SMALLUINT";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT16: {
-    return "SMALLINT";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT32: {
-    return "OPCUA_UINT";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT32: {
-    return "INT";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT64: {
-    return "OPCUA_BIGUINT";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT64: {
-    return "BIGINT";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_STATUSCODE: {
-    return "OPCUA_STATUSCODE";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_FLOAT: {
-    return "REAL";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_DOUBLE: {
-    return "DOUBLE PRECISION";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_DATETIME: {
-    return "TIMESTAMP(6)";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_BYTESTRING: {
-    return "BYTEA";
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_STRING: {
-    return "TEXT";
-  }
-  // NOLINTNEXTLINE(bugprone-branch-clone)
-  case UA_DataTypeKind::UA_DATATYPEKIND_GUID: {
-    [[fallthrough]];
-  }
-  default: {
-    string error_msg =
-        "Unhandeled UA_DataType detected: " + string(variant->typeName);
+  auto info = typeInfo(variant);
+  if (!info.registered) {
+    string error_msg = "Unhandeled UA_DataType detected: " +
+        string(variant == nullptr ? "Empty" : variant->typeName);
     throw logic_error(error_msg);
   }
-  }
+  return info.sql_type;
 }
 } // namespace open62541
@@ -1,7 +1,9 @@
 #include "UaVariantOperators.hpp"
+#include "TypeRegistry.hpp"
 
-#include <cmath>
+#include <limits>
 #include <stdexcept>
+#include <type_traits>
 
 namespace open62541 {
 using namespace std;
@@ -16,36 +18,49 @@ using namespace std;
 
 template <typename T> T multiply(const UA_Variant& lhs, const intmax_t& rhs) {
   auto lhs_value = *((T*)(lhs.data));
-  if (lhs_value > 0 && rhs > 0) {
-    if (lhs_value > numeric_limits<T>::max() / rhs) {
+  if constexpr (is_unsigned_v<T>) {
+    if (rhs < 0) {
+      // underflow, unless lhs is 0
+      return numeric_limits<T>::min();
+    }
+    if (rhs > 0 && lhs_value > numeric_limits<T>::max() / (uintmax_t)rhs) {
       // overflow
       return numeric_limits<T>::max();
     }
-  }
+    T value = lhs_value * (uintmax_t)rhs;
+    return value;
+  } else {
+    if (lhs_value > 0 && rhs > 0) {
+      if (lhs_value > numeric_limits<T>::max() / rhs) {
+        // overflow
+        return numeric_limits<T>::max();
+      }
+    }
 
-  if (lhs_value < 0 && rhs < 0) {
-    if (lhs_value < numeric_limits<T>::min() / rhs) {
-      // overflow
-      return numeric_limits<T>::max();
+    if (lhs_value < 0 && rhs < 0) {
+      if (lhs_value < numeric_limits<T>::max() / rhs) {
+        // overflow
+        return numeric_limits<T>::max();
+      }
     }
-  }
 
-  if (lhs_value < 0 && rhs > 0) {
-    if (rhs < numeric_limits<T>::min() / lhs_value) {
-      // underflow
-      return numeric_limits<T>::min();
+    if (lhs_value < 0 && rhs > 0) {
+      if (lhs_value < numeric_limits<T>::min() / rhs) {
+        // underflow
+        return numeric_limits<T>::min();
+      }
     }
-  }
 
-  if (lhs_value > 0 && rhs < 0) {
-    if (lhs_value < numeric_limits<T>::min() / rhs) {
-      // underflow
-      return numeric_limits<T>::min();
+    if (lhs_value > 0 && rhs < 0) {
+      if (rhs < numeric_limits<T>::min() / lhs_value) {
+        // underflow
+        return numeric_limits<T>::min();
+      }
     }
-  }
 
-  T value = round(lhs_value * rhs);
-  return value;
+    T value = lhs_value * rhs;
+    return value;
+  }
 }
 
 template <typename T>
@@ -54,7 +69,11 @@ T divideUnsigned(const UA_Variant& lhs, const intmax_t& rhs) {
   if (rhs == 0) {
     throw logic_error("Division by 0 is not allowed");
   }
-  T value = round(lhs_value / rhs);
+  if (rhs < 0) {
+    // underflow, unless lhs is 0
+    return numeric_limits<T>::min();
+  }
+  T value = lhs_value / (uintmax_t)rhs;
   return value;
 }
 
@@ -64,11 +83,11 @@ T divideSigned(const UA_Variant& lhs, const intmax_t& rhs) {
   if (rhs == 0) {
     throw logic_error("Division by 0 is not allowed");
   }
-  if (lhs_value == -1 && rhs == numeric_limits<intmax_t>::min()) {
+  if (lhs_value == numeric_limits<T>::min() && rhs == -1) {
     // overflow
     return numeric_limits<T>::max();
   }
-  T value = round(lhs_value / rhs);
+  T value = lhs_value / rhs;
   return value;
 }
 
@@ -76,7 +95,9 @@ template <typename T>
 T sumUnsigned(const UA_Variant& lhs, const UA_Variant& rhs) {
   auto lhs_value = *((T*)(lhs.data));
   auto rhs_value = *((T*)(rhs.data));
-  auto value = lhs_value + rhs_value;
+  // narrow types are promoted to int, so the sum is truncated before the
+  // overflow check
+  T value = lhs_value + rhs_value;
   if (value < lhs_value) {
     // overflow
     return numeric_limits<T>::max();
@@ -88,11 +109,11 @@ template <typename T>
 T sumSigned(const UA_Variant& lhs, const UA_Variant& rhs) {
   auto lhs_value = *((T*)(lhs.data));
   auto rhs_value = *((T*)(rhs.data));
-  if (lhs_value > numeric_limits<T>::max() - rhs_value) {
+  if (rhs_value > 0 && lhs_value > numeric_limits<T>::max() - rhs_value) {
     // overflow
     return numeric_limits<T>::max();
   }
-  if (lhs_value < numeric_limits<T>::min() + rhs_value) {
+  if (rhs_value < 0 && lhs_value < numeric_limits<T>::min() - rhs_value) {
     // underflow
     return numeric_limits<T>::min();
   }
@@ -105,11 +126,11 @@ T numericUnsignedDiff(const UA_Variant& lhs, const UA_Variant& rhs) {
   auto lhs_value = *((T*)(lhs.data));
   auto rhs_value = *((T*)(rhs.data));
   // @todo: use modulo for diff instead?
-  auto value = lhs_value - rhs_value;
   if (lhs_value < rhs_value) {
     // underflow
     return numeric_limits<T>::min();
   }
+  T value = lhs_value - rhs_value;
   return value;
 }
 
@@ -117,11 +138,11 @@ template <typename T>
 T numericSignedDiff(const UA_Variant& lhs, const UA_Variant& rhs) {
   auto lhs_value = *((T*)(lhs.data));
   auto rhs_value = *((T*)(rhs.data));
-  if (lhs_value > numeric_limits<T>::max() - rhs_value) {
+  if (rhs_value < 0 && lhs_value > numeric_limits<T>::max() + rhs_value) {
     // overflow
     return numeric_limits<T>::max();
   }
-  if (lhs_value < numeric_limits<T>::min() + rhs_value) {
+  if (rhs_value > 0 && lhs_value < numeric_limits<T>::min() + rhs_value) {
     // underflow
     return numeric_limits<T>::min();
   }
@@ -133,273 +154,132 @@ T numericSignedDiff(const UA_Variant& lhs, const UA_Variant& rhs) {
 #pragma GCC diagnostic pop
 #endif
 
-UA_Variant operator*(const UA_Variant& lhs, const intmax_t& rhs) {
-  if (lhs.type->typeKind == UA_DataTypeKind::UA_DATATYPEKIND_BOOLEAN) {
-    throw logic_error("Can not multiply Boolean values");
-  }
-
+template <typename Type> UA_Variant makeResult(typename Type::type value) {
   UA_Variant result;
   UA_Variant_init(&result);
-  switch (lhs.type->typeKind) {
-  case UA_DataTypeKind::UA_DATATYPEKIND_SBYTE: {
-    auto value = multiply<UA_SByte>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_SBYTE]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_BYTE: {
-    auto value = multiply<UA_Byte>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_BYTE]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT16: {
-    auto value = multiply<UA_UInt16>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT16]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT16: {
-    auto value = multiply<UA_Int16>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT16]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT32: {
-    auto value = multiply<UA_UInt32>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT32]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT32: {
-    auto value = multiply<UA_Int32>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT32]);
-    break;
+  UA_Variant_setScalarCopy(&result, &value, Type::dataType());
+  return result;
+}
+
+// floating point values are not clamped, they overflow into infinity
+template <typename Type> struct Multiply {
+  static UA_Variant apply(const UA_Variant& lhs, intmax_t rhs) {
+    using T = typename Type::type;
+    if constexpr (is_floating_point_v<T>) {
+      return makeResult<Type>(
+          static_cast<T>(Type::value(lhs) * static_cast<T>(rhs)));
+    } else {
+      return makeResult<Type>(multiply<T>(lhs, rhs));
+    }
   }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT64: {
-    auto value = multiply<UA_UInt64>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT64]);
-    break;
+};
+
+template <typename Type> struct Divide {
+  static UA_Variant apply(const UA_Variant& lhs, intmax_t rhs) {
+    using T = typename Type::type;
+    if constexpr (is_floating_point_v<T>) {
+      if (rhs == 0) {
+        throw logic_error("Division by 0 is not allowed");
+      }
+      return makeResult<Type>(
+          static_cast<T>(Type::value(lhs) / static_cast<T>(rhs)));
+    } else if constexpr (is_signed_v<T>) {
+      return makeResult<Type>(divideSigned<T>(lhs, rhs));
+    } else {
+      return makeResult<Type>(divideUnsigned<T>(lhs, rhs));
+    }
   }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT64: {
-    auto value = multiply<UA_Int64>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT64]);
-    break;
+};
+
+template <typename Type> struct Sum {
+  static UA_Variant apply(const UA_Variant& lhs, const UA_Variant& rhs) {
+    using T = typename Type::type;
+    if constexpr (is_floating_point_v<T>) {
+      return makeResult<Type>(Type::value(lhs) + Type::value(rhs));
+    } else if constexpr (is_signed_v<T>) {
+      return makeResult<Type>(sumSigned<T>(lhs, rhs));
+    } else {
+      return makeResult<Type>(sumUnsigned<T>(lhs, rhs));
+    }
   }
-  case UA_DataTypeKind::UA_DATATYPEKIND_FLOAT: {
-    auto value = multiply<float>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_FLOAT]);
-    break;
+};
+
+template <typename Type> struct Difference {
+  static UA_Variant apply(const UA_Variant& lhs, const UA_Variant& rhs) {
+    using T = typename Type::type;
+    if constexpr (is_floating_point_v<T>) {
+      return makeResult<Type>(Type::value(lhs) - Type::value(rhs));
+    } else if constexpr (is_signed_v<T>) {
+      return makeResult<Type>(numericSignedDiff<T>(lhs, rhs));
+    } else {
+      return makeResult<Type>(numericUnsignedDiff<T>(lhs, rhs));
+    }
   }
-  case UA_DataTypeKind::UA_DATATYPEKIND_DOUBLE: {
-    auto value = multiply<double>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
-    break;
+};
+
+using ScalingOperation = UA_Variant(const UA_Variant&, intmax_t);
+using BinaryOperation = UA_Variant(const UA_Variant&, const UA_Variant&);
+
+constexpr auto MULTIPLY =
+    makeDispatchTable<ScalingOperation, Multiply, true>(ScalarTypes{});
+constexpr auto DIVIDE =
+    makeDispatchTable<ScalingOperation, Divide, true>(ScalarTypes{});
+constexpr auto SUM =
+    makeDispatchTable<BinaryOperation, Sum, true>(ScalarTypes{});
+constexpr auto DIFFERENCE =
+    makeDispatchTable<BinaryOperation, Difference, true>(ScalarTypes{});
+
+UA_Variant operator*(const UA_Variant& lhs, const intmax_t& rhs) {
+  auto* operation = dispatch(MULTIPLY, lhs.type);
+  if (lhs.type != nullptr &&
+      lhs.type->typeKind == UA_DataTypeKind::UA_DATATYPEKIND_BOOLEAN) {
+    throw logic_error("Can not multiply Boolean values");
   }
-  default: {
+  if (operation == nullptr) {
     throw logic_error("Can not multiply non numeric data");
   }
-  }
-  return result;
+  return operation(lhs, rhs);
 }
 
 UA_Variant operator/(const UA_Variant& lhs, const intmax_t& rhs) {
-  if (lhs.type->typeKind == UA_DataTypeKind::UA_DATATYPEKIND_BOOLEAN) {
+  auto* operation = dispatch(DIVIDE, lhs.type);
+  if (lhs.type != nullptr &&
+      lhs.type->typeKind == UA_DataTypeKind::UA_DATATYPEKIND_BOOLEAN) {
     throw logic_error("Can not divide Boolean values");
   }
-
-  UA_Variant result;
-  UA_Variant_init(&result);
-  switch (lhs.type->typeKind) {
-  case UA_DataTypeKind::UA_DATATYPEKIND_SBYTE: {
-    auto value = divideSigned<UA_SByte>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_SBYTE]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_BYTE: {
-    auto value = divideUnsigned<UA_Byte>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_BYTE]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT16: {
-    auto value = divideUnsigned<UA_UInt16>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT16]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT16: {
-    auto value = divideSigned<UA_Int16>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT16]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT32: {
-    auto value = divideUnsigned<UA_UInt32>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT32]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT32: {
-    auto value = divideSigned<UA_Int32>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT32]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT64: {
-    auto value = divideUnsigned<UA_UInt64>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT64]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT64: {
-    auto value = divideSigned<UA_Int64>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT64]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_FLOAT: {
-    auto value = divideSigned<float>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_FLOAT]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_DOUBLE: {
-    auto value = divideSigned<double>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
-    break;
-  }
-  default: {
+  if (operation == nullptr) {
     throw logic_error("Can not divide non numeric data");
   }
-  }
-  return result;
+  return operation(lhs, rhs);
 }
 
 UA_Variant operator+(const UA_Variant& lhs, const UA_Variant& rhs) {
-  if (lhs.type->typeKind != rhs.type->typeKind) {
+  if (lhs.type != rhs.type) {
     throw logic_error("Can not not add non matching numeric types");
   }
-
-  if (lhs.type->typeKind == UA_DataTypeKind::UA_DATATYPEKIND_BOOLEAN) {
+  auto* operation = dispatch(SUM, lhs.type);
+  if (lhs.type != nullptr &&
+      lhs.type->typeKind == UA_DataTypeKind::UA_DATATYPEKIND_BOOLEAN) {
     throw logic_error("Can not add Boolean values");
   }
-
-  UA_Variant result;
-  UA_Variant_init(&result);
-
-  switch (lhs.type->typeKind) {
-  case UA_DataTypeKind::UA_DATATYPEKIND_SBYTE: {
-    auto value = sumUnsigned<UA_SByte>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_SBYTE]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_BYTE: {
-    auto value = sumSigned<UA_Byte>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_BYTE]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT16: {
-    auto value = sumSigned<UA_UInt16>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT16]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT16: {
-    auto value = sumUnsigned<UA_Int16>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT16]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT32: {
-    auto value = sumSigned<UA_UInt32>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT32]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT32: {
-    auto value = sumUnsigned<UA_Int32>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT32]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT64: {
-    auto value = sumSigned<UA_UInt64>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT64]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT64: {
-    auto value = sumUnsigned<UA_Int64>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT64]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_FLOAT: {
-    auto value = sumUnsigned<float>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_FLOAT]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_DOUBLE: {
-    auto value = sumUnsigned<double>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
-    break;
-  }
-  default: {
+  if (operation == nullptr) {
     throw logic_error("Can not add non numeric data");
   }
-  }
-  return result;
+  return operation(lhs, rhs);
 }
 
 UA_Variant operator-(const UA_Variant& lhs, const UA_Variant& rhs) {
-  if (lhs.type->typeKind != rhs.type->typeKind) {
+  if (lhs.type != rhs.type) {
     throw logic_error("Can not not subtract non matching numeric types");
   }
-
-  if (lhs.type->typeKind == UA_DataTypeKind::UA_DATATYPEKIND_BOOLEAN) {
+  auto* operation = dispatch(DIFFERENCE, lhs.type);
+  if (lhs.type != nullptr &&
+      lhs.type->typeKind == UA_DataTypeKind::UA_DATATYPEKIND_BOOLEAN) {
     throw logic_error("Can not subtract Boolean values");
   }
-
-  UA_Variant result;
-  UA_Variant_init(&result);
-
-  switch (lhs.type->typeKind) {
-  case UA_DataTypeKind::UA_DATATYPEKIND_SBYTE: {
-    auto value = numericSignedDiff<UA_SByte>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_SBYTE]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_BYTE: {
-    auto value = numericUnsignedDiff<UA_Byte>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_BYTE]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT16: {
-    auto value = numericUnsignedDiff<UA_UInt16>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT16]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT16: {
-    auto value = numericSignedDiff<UA_Int16>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT16]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT32: {
-    auto value = numericUnsignedDiff<UA_UInt32>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT32]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT32: {
-    auto value = numericSignedDiff<UA_Int32>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT32]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT64: {
-    auto value = numericUnsignedDiff<UA_UInt64>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT64]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT64: {
-    auto value = numericSignedDiff<UA_Int64>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT64]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_FLOAT: {
-    auto value = numericSignedDiff<float>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_FLOAT]);
-    break;
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_DOUBLE: {
-    auto value = numericSignedDiff<double>(lhs, rhs);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
-    break;
-  }
-  default: {
+  if (operation == nullptr) {
     throw logic_error("Can not subtract non numeric data");
   }
-  }
-  return result;
+  return operation(lhs, rhs);
 }
-} // namespace open62541
\ No newline at end of file
+} // namespace open62541
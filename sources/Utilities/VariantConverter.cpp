@@ -1,8 +1,13 @@
 #include "VariantConverter.hpp"
 #include "StringConverter.hpp"
+#include "TypeRegistry.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
 
 namespace open62541 {
 using namespace std;
@@ -39,144 +44,201 @@ UA_NodeId toNodeId(DataType type) {
   }
 }
 
+/**
+ * @brief Allocate the scalar of the given type and assign the given value to
+ * it, the value must not own any memory
+ *
+ */
+template <typename T>
+void setScalar(UA_Variant* target, T value, const UA_DataType* type) {
+  auto* scalar = static_cast<T*>(UA_new(type));
+  if (scalar == nullptr) {
+    throw bad_alloc();
+  }
+  *scalar = value;
+  UA_Variant_setScalar(target, scalar, type);
+}
+
+/**
+ * @brief Allocate a UA_String or UA_ByteString scalar and copy the given
+ * bytes into its only buffer
+ *
+ */
+void setBytes(UA_Variant* target, const void* data, size_t length,
+    const UA_DataType* type) {
+  // UA_ByteString is a typedef of UA_String
+  auto* scalar = static_cast<UA_String*>(UA_new(type));
+  if (scalar == nullptr) {
+    throw bad_alloc();
+  }
+  if (length > 0) {
+    scalar->data = static_cast<UA_Byte*>(UA_malloc(length));
+    if (scalar->data == nullptr) {
+      UA_free(scalar);
+      throw bad_alloc();
+    }
+    memcpy(scalar->data, data, length);
+    scalar->length = length;
+  } else {
+    // an empty, but not a null string
+    scalar->data = static_cast<UA_Byte*>(UA_EMPTY_ARRAY_SENTINEL);
+  }
+  UA_Variant_setScalar(target, scalar, type);
+}
+
 // In this case, code is easier to understand WITH magic numbers
 // NOLINTBEGIN(readability-magic-numbers)
-UA_Variant toUAVariant(const DataVariant& variant) {
-  // @todo: refactor into to avoid callers having to create another copy:
-  // void toUAVariant(const DataVariant& variant, UA_Variant*)
-  UA_Variant result;
-  UA_Variant_init(&result);
+UA_DateTime toUADateTime(const Timestamp& value) {
+  UA_DateTimeStruct date_time_struct;
+  date_time_struct.year = static_cast<UA_Int16>(value.year);
+  date_time_struct.month = (UA_UInt16)value.month;
+  date_time_struct.day = (UA_UInt16)value.day;
+  date_time_struct.hour = (UA_UInt16)value.hours;
+  date_time_struct.min = (UA_UInt16)value.minutes;
+  date_time_struct.sec = (UA_UInt16)value.seconds;
+  date_time_struct.milliSec = (UA_UInt16)(floor(value.microseconds / 1000));
+  date_time_struct.microSec = (UA_UInt16)(value.microseconds % 1000);
+  date_time_struct.nanoSec = 0;
+  return UA_DateTime_fromStruct(date_time_struct);
+}
+
+void toUAVariant(const DataVariant& variant, UA_Variant* target) {
+  UA_Variant_init(target);
   if (holds_alternative<bool>(variant)) {
-    auto value = get<bool>(variant);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    setScalar<UA_Boolean>(
+        target, get<bool>(variant), &UA_TYPES[UA_TYPES_BOOLEAN]);
   } else if (holds_alternative<uintmax_t>(variant)) {
-    auto value = get<uintmax_t>(variant);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_UINT64]);
+    setScalar<UA_UInt64>(
+        target, get<uintmax_t>(variant), &UA_TYPES[UA_TYPES_UINT64]);
   } else if (holds_alternative<intmax_t>(variant)) {
-    auto value = get<intmax_t>(variant);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_INT64]);
+    setScalar<UA_Int64>(
+        target, get<intmax_t>(variant), &UA_TYPES[UA_TYPES_INT64]);
   } else if (holds_alternative<double>(variant)) {
-    auto value = get<double>(variant);
-    UA_Variant_setScalarCopy(&result, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+    setScalar<UA_Double>(
+        target, get<double>(variant), &UA_TYPES[UA_TYPES_DOUBLE]);
   } else if (holds_alternative<Timestamp>(variant)) {
-    auto value = get<Timestamp>(variant);
-    UA_DateTimeStruct date_time_struct;
-    date_time_struct.year = static_cast<UA_Int16>(value.year);
-    date_time_struct.month = (UA_UInt16)value.month;
-    date_time_struct.day = (UA_UInt16)value.day;
-    date_time_struct.hour = (UA_UInt16)value.hours;
-    date_time_struct.min = (UA_UInt16)value.minutes;
-    date_time_struct.sec = (UA_UInt16)value.seconds;
-    date_time_struct.milliSec = (UA_UInt16)(floor(value.microseconds / 1000));
-    date_time_struct.microSec = (UA_UInt16)(value.microseconds % 1000);
-    date_time_struct.nanoSec = 0;
-    auto date_time = UA_DateTime_fromStruct(date_time_struct);
-    UA_Variant_setScalarCopy(&result, &date_time, &UA_TYPES[UA_TYPES_DATETIME]);
+    setScalar<UA_DateTime>(target, toUADateTime(get<Timestamp>(variant)),
+        &UA_TYPES[UA_TYPES_DATETIME]);
   } else if (holds_alternative<string>(variant)) {
-    auto ua_string = makeUAString(get<string>(variant));
-    UA_Variant_setScalarCopy(&result, &ua_string, &UA_TYPES[UA_TYPES_STRING]);
-    UA_String_clear(&ua_string);
+    const auto& value = get<string>(variant);
+    setBytes(target, value.data(), value.size(), &UA_TYPES[UA_TYPES_STRING]);
   } else if (holds_alternative<vector<uint8_t>>(variant)) {
-    auto ua_byte_string = makeUAByteString(get<vector<uint8_t>>(variant));
-    UA_Variant_setScalarCopy(
-        &result, &ua_byte_string, &UA_TYPES[UA_TYPES_BYTESTRING]);
-    UA_String_clear(&ua_byte_string);
+    const auto& value = get<vector<uint8_t>>(variant);
+    setBytes(
+        target, value.data(), value.size(), &UA_TYPES[UA_TYPES_BYTESTRING]);
   } else {
     throw runtime_error("Could not convert Information_Model::DataVariant into "
                         "open62541 UA_Variant due to an unhandled "
                         "Information_Model::DataVariant value type");
   }
-
-  return result;
 }
 
-DataVariant toDataVariant(const UA_Variant& variant) {
-  switch (variant.type->typeKind) {
-  case UA_DataTypeKind::UA_DATATYPEKIND_BOOLEAN: {
-    bool value = *((bool*)(variant.data));
-    return DataVariant(value);
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_SBYTE: {
-    // NOLINTNEXTLINE(bugprone-signed-char-misuse,cert-str34-c)
-    intmax_t value = *((UA_SByte*)(variant.data)); // this is not a char
-    return DataVariant(value);
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT16: {
-    intmax_t value = *((UA_Int16*)(variant.data));
-    return DataVariant(value);
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT32: {
-    intmax_t value = *((UA_Int32*)(variant.data));
-    return DataVariant(value);
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_INT64: {
-    intmax_t value = *((UA_Int64*)(variant.data));
-    return DataVariant(value);
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_DATETIME: {
-    UA_DateTimeStruct time_value =
-        UA_DateTime_toStruct(*(UA_DateTime*)(variant.data));
-    Timestamp value{.year = static_cast<uint16_t>(time_value.year),
-        .month = static_cast<uint8_t>(time_value.month),
-        .day = static_cast<uint8_t>(time_value.day),
-        .hours = static_cast<uint8_t>(time_value.hour),
-        .minutes = static_cast<uint8_t>(time_value.min),
-        .seconds = static_cast<uint8_t>(time_value.sec),
-        .microseconds = static_cast<uint32_t>(
-            (time_value.milliSec * 1000) + time_value.microSec)};
-    return DataVariant(value);
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_BYTE: {
-    uintmax_t value = *((UA_Byte*)(variant.data));
-    return DataVariant(value);
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT16: {
-    uintmax_t value = *((UA_UInt16*)(variant.data));
-    return DataVariant(value);
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT32: {
-    uintmax_t value = *((UA_UInt32*)(variant.data));
-    return DataVariant(value);
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_UINT64: {
-    uintmax_t value = *((UA_UInt64*)(variant.data));
-    return DataVariant(value);
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_STATUSCODE: {
-    UA_StatusCode status_code = *((UA_StatusCode*)(variant.data));
-    auto value = string(UA_StatusCode_name(status_code));
-    if (!value.empty()) {
-      return DataVariant(value);
-    } else {
-      // if no human readable string is available, return the code as an integer
-      return DataVariant(to_string(status_code));
-    }
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_FLOAT: {
-    double value = *((UA_Float*)(variant.data));
-    return DataVariant(value);
+UA_StatusCode toUAVariant(const DataVariant& variant,
+    const UA_NumericRange& range, UA_Variant* target) {
+  UA_Variant_init(target);
+  // strings and byte strings are indexed like one dimensional arrays
+  if (range.dimensionsSize != 1) {
+    return UA_STATUSCODE_BADINDEXRANGENODATA;
   }
-  case UA_DataTypeKind::UA_DATATYPEKIND_DOUBLE: {
-    double value = *((UA_Double*)(variant.data));
-    return DataVariant(value);
+  const auto& bounds = range.dimensions[0];
+  if (bounds.min > bounds.max) {
+    return UA_STATUSCODE_BADINDEXRANGEINVALID;
   }
-  case UA_DataTypeKind::UA_DATATYPEKIND_BYTESTRING: {
-    auto* byte_string = (UA_ByteString*)(variant.data);
-    auto value = vector<uint8_t>(
-        byte_string->data, byte_string->data + byte_string->length);
-    return DataVariant(value);
-  }
-  case UA_DataTypeKind::UA_DATATYPEKIND_STRING: {
-    auto* ua_string = (UA_String*)(variant.data);
-    auto value = toString(ua_string);
-    return DataVariant(value);
+
+  const UA_Byte* data = nullptr;
+  size_t length = 0;
+  const UA_DataType* type = nullptr;
+  if (holds_alternative<string>(variant)) {
+    const auto& value = get<string>(variant);
+    data = reinterpret_cast<const UA_Byte*>(value.data());
+    length = value.size();
+    type = &UA_TYPES[UA_TYPES_STRING];
+  } else if (holds_alternative<vector<uint8_t>>(variant)) {
+    const auto& value = get<vector<uint8_t>>(variant);
+    data = value.data();
+    length = value.size();
+    type = &UA_TYPES[UA_TYPES_BYTESTRING];
+  } else {
+    return UA_STATUSCODE_BADINDEXRANGENODATA;
   }
-  default: {
-    string error_msg = string(variant.type->typeName) +
-        " into Information_Model::DataVariant conversion is not supported";
-    throw runtime_error(error_msg);
+
+  if (bounds.min >= length) {
+    return UA_STATUSCODE_BADINDEXRANGENODATA;
   }
+  size_t last = min<size_t>(bounds.max, length - 1);
+  setBytes(target, data + bounds.min, last - bounds.min + 1, type);
+  return UA_STATUSCODE_GOOD;
+}
+
+UA_Variant toUAVariant(const DataVariant& variant) {
+  UA_Variant result;
+  toUAVariant(variant, &result);
+  return result;
+}
+
+Timestamp toTimestamp(UA_DateTime date_time) {
+  UA_DateTimeStruct time_value = UA_DateTime_toStruct(date_time);
+  return Timestamp{.year = static_cast<uint16_t>(time_value.year),
+      .month = static_cast<uint8_t>(time_value.month),
+      .day = static_cast<uint8_t>(time_value.day),
+      .hours = static_cast<uint8_t>(time_value.hour),
+      .minutes = static_cast<uint8_t>(time_value.min),
+      .seconds = static_cast<uint8_t>(time_value.sec),
+      .microseconds = static_cast<uint32_t>(
+          (time_value.milliSec * 1000) + time_value.microSec)};
+}
+
+template <typename Type> struct ToDataVariant {
+  static DataVariant apply(const UA_Variant& variant) {
+    using T = typename Type::type;
+    const auto& value = Type::value(variant);
+    if constexpr (Type::kind == UA_DATATYPEKIND_BOOLEAN) {
+      return DataVariant(static_cast<bool>(value));
+    } else if constexpr (Type::kind == UA_DATATYPEKIND_STATUSCODE) {
+      auto name = string(UA_StatusCode_name(value));
+      if (!name.empty()) {
+        return DataVariant(name);
+      } else {
+        // if no human readable string is available, return the code as an
+        // integer
+        return DataVariant(to_string(value));
+      }
+    } else if constexpr (Type::kind == UA_DATATYPEKIND_DATETIME) {
+      return DataVariant(toTimestamp(value));
+    } else if constexpr (Type::kind == UA_DATATYPEKIND_BYTESTRING) {
+      return DataVariant(
+          vector<uint8_t>(value.data, value.data + value.length));
+    } else if constexpr (Type::kind == UA_DATATYPEKIND_STRING) {
+      return DataVariant(toString(&value));
+    } else if constexpr (is_floating_point_v<T>) {
+      return DataVariant(static_cast<double>(value));
+    } else if constexpr (is_signed_v<T>) {
+      return DataVariant(static_cast<intmax_t>(value));
+    } else {
+      return DataVariant(static_cast<uintmax_t>(value));
+    }
   }
+};
+
+constexpr auto TO_DATA_VARIANT =
+    makeDispatchTable<DataVariant(const UA_Variant&), ToDataVariant>(
+        ScalarTypes{});
+
+DataVariant toDataVariant(const UA_Variant& variant) {
+  if (!UA_Variant_isScalar(&variant)) {
+    // empty arrays point to UA_EMPTY_ARRAY_SENTINEL, they must not be read
+    throw runtime_error(
+        "Array into Information_Model::DataVariant conversion is not "
+        "supported");
+  }
+  auto* convert = dispatch(TO_DATA_VARIANT, variant.type);
+  if (convert == nullptr) {
+    string type_name =
+        variant.type == nullptr ? "Empty" : string(variant.type->typeName);
+    throw runtime_error(type_name +
+        " into Information_Model::DataVariant conversion is not supported");
+  }
+  return convert(variant);
 }
 // NOLINTEND(readability-magic-numbers)
 } // namespace open62541
\ No newline at end of file
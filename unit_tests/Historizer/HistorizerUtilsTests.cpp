@@ -0,0 +1,260 @@
+#include "HistorizerUtils.hpp"
+#include "StringConverter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std;
+using namespace open62541;
+
+namespace {
+template <typename T>
+UA_Variant makeVariant(T value, const UA_DataType* type) {
+  UA_Variant result;
+  UA_Variant_init(&result);
+  UA_Variant_setScalarCopy(&result, &value, type);
+  return result;
+}
+
+/**
+ * @brief Allocates data values, that hold the given Int32 values
+ *
+ */
+UA_DataValue* makeDataValues(initializer_list<UA_Int32> values) {
+  auto* result = static_cast<UA_DataValue*>(
+      UA_Array_new(values.size(), &UA_TYPES[UA_TYPES_DATAVALUE]));
+  size_t i = 0;
+  for (auto value : values) {
+    result[i].value = makeVariant(value, &UA_TYPES[UA_TYPES_INT32]);
+    result[i].hasValue = true;
+    ++i;
+  }
+  return result;
+}
+
+UA_Int32 valueOf(const UA_DataValue& data_value) {
+  return *static_cast<const UA_Int32*>(data_value.value.data);
+}
+
+/**
+ * @brief Interpolates between two values of the given type and reads the
+ * result as the same type
+ *
+ */
+template <typename T>
+T interpolate(int64_t target, T before, T after, const UA_DataType* type) {
+  auto before_variant = makeVariant(before, type);
+  auto after_variant = makeVariant(after, type);
+  auto result =
+      interpolateValue(target, 0, before_variant, 4, after_variant);
+  EXPECT_EQ(result.type, type);
+  auto value = *static_cast<T*>(result.data);
+  UA_Variant_clear(&result);
+  UA_Variant_clear(&after_variant);
+  UA_Variant_clear(&before_variant);
+  return value;
+}
+} // namespace
+
+TEST(HistorizerUtilsTests, parsesDatabaseTimestamps) {
+  auto timestamp = toUaDateTime(string("2024-02-29 13:05:09.123456"));
+  EXPECT_EQ(toString(timestamp), "2024-02-29 13:05:09.123456");
+  timestamp = toUaDateTime(string("2024-02-29 13:05:09"));
+  EXPECT_EQ(toString(timestamp), "2024-02-29 13:05:09.000000");
+}
+
+TEST(HistorizerUtilsTests, parsesFormattedTimestamps) {
+  auto timestamp = UA_DateTime_now();
+  // UA_DateTime has 100 ns ticks, only microseconds are formatted
+  auto expected = timestamp - timestamp % UA_DATETIME_USEC;
+  EXPECT_EQ(toUaDateTime(toString(timestamp)), expected);
+}
+
+TEST(HistorizerUtilsTests, rejectsMalformedTimestamps) {
+  EXPECT_THROW(toUaDateTime(string("not a timestamp")), logic_error);
+  EXPECT_THROW(toUaDateTime(string("")), logic_error);
+}
+
+TEST(HistorizerUtilsTests, convertsUnixMicroseconds) {
+  EXPECT_EQ(toUnixMicroseconds(UA_DATETIME_UNIX_EPOCH), 0);
+  EXPECT_EQ(toUaDateTime(int64_t{0}), UA_DATETIME_UNIX_EPOCH);
+  auto timestamp = UA_DATETIME_UNIX_EPOCH + 42 * UA_DATETIME_USEC;
+  EXPECT_EQ(toUnixMicroseconds(timestamp), 42);
+  EXPECT_EQ(toUaDateTime(toUnixMicroseconds(timestamp)), timestamp);
+}
+
+TEST(HistorizerUtilsTests, encodesContinuationPoints) {
+  ContinuationPoint position{-1234567890123, 42};
+  auto encoded = makeContinuationPoint(position);
+  auto decoded = readContinuationPoint(&encoded);
+  UA_ByteString_clear(&encoded);
+
+  ASSERT_TRUE(decoded.has_value());
+  EXPECT_EQ(decoded->source_micros, position.source_micros);
+  EXPECT_EQ(decoded->index, position.index);
+}
+
+TEST(HistorizerUtilsTests, readsEmptyContinuationPoints) {
+  EXPECT_FALSE(readContinuationPoint(nullptr).has_value());
+  auto empty = UA_BYTESTRING_NULL;
+  EXPECT_FALSE(readContinuationPoint(&empty).has_value());
+}
+
+TEST(HistorizerUtilsTests, rejectsMalformedContinuationPoints) {
+  auto encoded = makeContinuationPoint(ContinuationPoint{1, 2});
+  ++encoded.data[0];
+  EXPECT_THROW(readContinuationPoint(&encoded), invalid_argument);
+  --encoded.data[0];
+  --encoded.length;
+  EXPECT_THROW(readContinuationPoint(&encoded), invalid_argument);
+  ++encoded.length;
+  UA_ByteString_clear(&encoded);
+
+  auto text = UA_BYTESTRING_STATIC("continue");
+  EXPECT_THROW(readContinuationPoint(&text), invalid_argument);
+}
+
+TEST(HistorizerUtilsTests, namesHistoryTables) {
+  EXPECT_EQ(toHistoryTable("INT"), "History_INT");
+  EXPECT_EQ(toHistoryTable("DOUBLE PRECISION"), "History_DOUBLE_PRECISION");
+  EXPECT_EQ(toHistoryTable("TIMESTAMP(6)"), "History_TIMESTAMP_6");
+  EXPECT_EQ(toHistoryTable("OPCUA_TINYINT"), "History_OPCUA_TINYINT");
+}
+
+TEST(HistorizerUtilsTests, adoptsDataValuesOfEmptyHistory) {
+  UA_HistoryData history;
+  UA_HistoryData_init(&history);
+  auto* values = makeDataValues({1, 2});
+
+  ASSERT_EQ(appendUADataValue(&history, values, 2), UA_STATUSCODE_GOOD);
+  EXPECT_EQ(history.dataValues, values);
+  EXPECT_EQ(history.dataValuesSize, 2);
+  UA_HistoryData_clear(&history);
+}
+
+TEST(HistorizerUtilsTests, appendsDataValues) {
+  UA_HistoryData history;
+  UA_HistoryData_init(&history);
+  ASSERT_EQ(appendUADataValue(&history, makeDataValues({1, 2}), 2),
+      UA_STATUSCODE_GOOD);
+  ASSERT_EQ(appendUADataValue(&history, makeDataValues({3, 4, 5}), 3),
+      UA_STATUSCODE_GOOD);
+
+  ASSERT_EQ(history.dataValuesSize, 5);
+  for (size_t i = 0; i < history.dataValuesSize; ++i) {
+    EXPECT_EQ(valueOf(history.dataValues[i]), static_cast<UA_Int32>(i + 1));
+  }
+  UA_HistoryData_clear(&history);
+}
+
+TEST(HistorizerUtilsTests, ignoresEmptyDataValues) {
+  UA_HistoryData history;
+  UA_HistoryData_init(&history);
+  ASSERT_EQ(appendUADataValue(&history, makeDataValues({1}), 1),
+      UA_STATUSCODE_GOOD);
+  ASSERT_EQ(appendUADataValue(&history, nullptr, 0), UA_STATUSCODE_GOOD);
+
+  ASSERT_EQ(history.dataValuesSize, 1);
+  EXPECT_EQ(valueOf(history.dataValues[0]), 1);
+  UA_HistoryData_clear(&history);
+}
+
+TEST(HistorizerUtilsTests, expandsHistoryResults) {
+  UA_HistoryData history;
+  UA_HistoryData_init(&history);
+  ASSERT_EQ(appendUADataValue(&history, makeDataValues({1}), 1),
+      UA_STATUSCODE_GOOD);
+
+  HistoryResults results;
+  for (UA_Int32 value : {2, 3}) {
+    auto& result = results.append();
+    result.value = makeVariant(value, &UA_TYPES[UA_TYPES_INT32]);
+    result.hasValue = true;
+  }
+  ASSERT_EQ(expandHistoryResult(&history, move(results)), UA_STATUSCODE_GOOD);
+  EXPECT_TRUE(results.empty()); // NOLINT(bugprone-use-after-move)
+
+  ASSERT_EQ(history.dataValuesSize, 3);
+  EXPECT_EQ(valueOf(history.dataValues[0]), 1);
+  EXPECT_EQ(valueOf(history.dataValues[1]), 2);
+  EXPECT_EQ(valueOf(history.dataValues[2]), 3);
+  UA_HistoryData_clear(&history);
+}
+
+TEST(HistorizerUtilsTests, interpolatesFloatingPointValues) {
+  EXPECT_DOUBLE_EQ(
+      interpolate<UA_Double>(1, 1.0, 3.0, &UA_TYPES[UA_TYPES_DOUBLE]), 1.5);
+  EXPECT_FLOAT_EQ(
+      interpolate<UA_Float>(3, 0.0F, -4.0F, &UA_TYPES[UA_TYPES_FLOAT]), -3.0F);
+}
+
+TEST(HistorizerUtilsTests, roundsInterpolatedIntegers) {
+  const auto* type = &UA_TYPES[UA_TYPES_INT32];
+  EXPECT_EQ(interpolate<UA_Int32>(1, 0, 10, type), 3);
+  EXPECT_EQ(interpolate<UA_Int32>(1, 0, -10, type), -3);
+  EXPECT_EQ(interpolate<UA_Int32>(2, 0, 10, type), 5);
+  EXPECT_EQ(interpolate<UA_Int32>(4, 0, 10, type), 10);
+}
+
+TEST(HistorizerUtilsTests, keepsInterpolatedIntegersInRange) {
+  EXPECT_EQ(
+      interpolate<UA_Byte>(3, 0, 255, &UA_TYPES[UA_TYPES_BYTE]), 191);
+  EXPECT_EQ(interpolate<UA_SByte>(4, -128, 127, &UA_TYPES[UA_TYPES_SBYTE]),
+      127);
+  EXPECT_EQ(interpolate<UA_UInt64>(4, 0, UINT64_MAX - 2047,
+                &UA_TYPES[UA_TYPES_UINT64]),
+      UINT64_MAX - 2047);
+}
+
+TEST(HistorizerUtilsTests, interpolatesLargeIntegersExactly) {
+  // 2^53 + 1 is the first integer, that a double can not represent
+  constexpr int64_t above_double = (int64_t{1} << 53) + 1;
+  EXPECT_EQ(interpolate<UA_Int64>(2, above_double, above_double + 4,
+                &UA_TYPES[UA_TYPES_INT64]),
+      above_double + 2);
+  EXPECT_EQ(interpolate<UA_UInt64>(1, UINT64_MAX - 8, UINT64_MAX,
+                &UA_TYPES[UA_TYPES_UINT64]),
+      UINT64_MAX - 6);
+  EXPECT_EQ(interpolate<UA_Int64>(
+                1, INT64_MIN, INT64_MIN + 5, &UA_TYPES[UA_TYPES_INT64]),
+      INT64_MIN + 1);
+}
+
+TEST(HistorizerUtilsTests, interpolatesValuesWithoutTimeSpan) {
+  auto before = makeVariant<UA_Int32>(1, &UA_TYPES[UA_TYPES_INT32]);
+  auto after = makeVariant<UA_Int32>(2, &UA_TYPES[UA_TYPES_INT32]);
+  auto result = interpolateValue(3, 3, before, 3, after);
+  EXPECT_EQ(*static_cast<UA_Int32*>(result.data), 1);
+  UA_Variant_clear(&result);
+  UA_Variant_clear(&after);
+  UA_Variant_clear(&before);
+}
+
+TEST(HistorizerUtilsTests, interpolatesIntegerLimits) {
+  EXPECT_EQ(interpolate<UA_UInt64>(
+                2, UINT64_MAX, UINT64_MAX, &UA_TYPES[UA_TYPES_UINT64]),
+      UINT64_MAX);
+  EXPECT_EQ(interpolate<UA_Int64>(
+                2, INT64_MAX, INT64_MAX, &UA_TYPES[UA_TYPES_INT64]),
+      INT64_MAX);
+  EXPECT_EQ(interpolate<UA_Int64>(
+                2, INT64_MIN, INT64_MIN, &UA_TYPES[UA_TYPES_INT64]),
+      INT64_MIN);
+}
+
+TEST(HistorizerUtilsTests, rejectsNonInterpolatableValues) {
+  auto lhs = makeVariant<UA_Int32>(1, &UA_TYPES[UA_TYPES_INT32]);
+  auto rhs = makeVariant<UA_Int64>(1, &UA_TYPES[UA_TYPES_INT64]);
+  EXPECT_THROW(interpolateValue(1, 0, lhs, 2, rhs), logic_error);
+  UA_Variant_clear(&rhs);
+
+  UA_Boolean flag = true;
+  auto boolean = makeVariant(flag, &UA_TYPES[UA_TYPES_BOOLEAN]);
+  EXPECT_THROW(interpolateValue(1, 0, boolean, 2, boolean), logic_error);
+  UA_Variant_clear(&boolean);
+  UA_Variant_clear(&lhs);
+}
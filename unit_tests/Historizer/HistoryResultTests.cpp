@@ -0,0 +1,93 @@
+#include "HistoryResult.hpp"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+
+using namespace std;
+using namespace open62541;
+
+namespace {
+void appendInt32(HistoryResults* results, UA_Int32 value) {
+  auto& result = results->append();
+  UA_Variant_setScalarCopy(&result.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+  result.hasValue = true;
+}
+
+UA_Int32 valueOf(const UA_DataValue& data_value) {
+  return *static_cast<const UA_Int32*>(data_value.value.data);
+}
+} // namespace
+
+TEST(HistoryResultTests, isEmptyByDefault) {
+  HistoryResults results;
+  EXPECT_TRUE(results.empty());
+  EXPECT_EQ(results.size(), 0);
+  EXPECT_EQ(results.release(), nullptr);
+}
+
+TEST(HistoryResultTests, appendsValues) {
+  HistoryResults results;
+  results.reserve(2);
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  for (UA_Int32 value = 0; value < 5; ++value) {
+    appendInt32(&results, value);
+    EXPECT_EQ(valueOf(results.back()), value);
+  }
+  EXPECT_FALSE(results.empty());
+  EXPECT_EQ(results.size(), 5);
+}
+
+TEST(HistoryResultTests, appendsEmptyValues) {
+  HistoryResults results;
+  auto& result = results.append();
+  EXPECT_FALSE(result.hasValue);
+  EXPECT_FALSE(result.hasSourceTimestamp);
+  EXPECT_TRUE(UA_Variant_isEmpty(&result.value));
+}
+
+TEST(HistoryResultTests, reversesValues) {
+  HistoryResults results;
+  appendInt32(&results, 1);
+  appendInt32(&results, 2);
+  appendInt32(&results, 3);
+  results.reverse();
+
+  auto size = results.size();
+  auto* values = results.release();
+  ASSERT_NE(values, nullptr);
+  EXPECT_EQ(valueOf(values[0]), 3);
+  EXPECT_EQ(valueOf(values[1]), 2);
+  EXPECT_EQ(valueOf(values[2]), 1);
+  UA_Array_delete(values, size, &UA_TYPES[UA_TYPES_DATAVALUE]);
+}
+
+TEST(HistoryResultTests, releasesValues) {
+  HistoryResults results;
+  appendInt32(&results, 1);
+  appendInt32(&results, 2);
+
+  auto* values = results.release();
+  ASSERT_NE(values, nullptr);
+  EXPECT_TRUE(results.empty());
+  EXPECT_EQ(results.release(), nullptr);
+  UA_Array_delete(values, 2, &UA_TYPES[UA_TYPES_DATAVALUE]);
+}
+
+TEST(HistoryResultTests, movesValues) {
+  HistoryResults results;
+  appendInt32(&results, 1);
+  appendInt32(&results, 2);
+
+  HistoryResults moved(move(results));
+  EXPECT_TRUE(results.empty()); // NOLINT(bugprone-use-after-move)
+  EXPECT_EQ(moved.size(), 2);
+  EXPECT_EQ(valueOf(moved.back()), 2);
+
+  HistoryResults assigned;
+  appendInt32(&assigned, 3);
+  assigned = move(moved);
+  EXPECT_TRUE(moved.empty()); // NOLINT(bugprone-use-after-move)
+  EXPECT_EQ(assigned.size(), 2);
+  EXPECT_EQ(valueOf(assigned.back()), 2);
+}
@@ -0,0 +1,121 @@
+#include "CallbackRepo.hpp"
+#include "NodeBuilder.hpp"
+#include "RegistrationPipeline.hpp"
+
+#include <Information_Model_Mocks/MockBuilder.hpp>
+#include <gtest/gtest.h>
+#include <open62541/server.h>
+
+#include <memory>
+#include <string>
+
+using namespace std;
+using namespace open62541;
+using namespace Information_Model;
+
+namespace {
+constexpr UA_UInt16 SERVER_NAMESPACE = 1;
+constexpr size_t DEVICE_COUNT = 64;
+
+DevicePtr makeDevice(const string& id) {
+  auto mock_builder = make_shared<Information_Model::testing::MockBuilder>();
+  mock_builder->setDeviceInfo(id, {"Device", "Registration test device"});
+  mock_builder->addReadable({"Value", "Registration test value"}, 1.0);
+  return mock_builder->result();
+}
+
+string makeId(size_t i) { return "Device_" + to_string(i); }
+
+struct RegistrationPipelineTests : public ::testing::Test {
+  void SetUp() override {
+    server = UA_Server_new();
+    ASSERT_NE(server, nullptr);
+    repo = make_shared<CallbackRepo>();
+    builder = make_shared<NodeBuilder>(repo,
+#ifdef ENABLE_UA_HISTORIZING
+        nullptr,
+#endif // ENABLE_UA_HISTORIZING
+        server);
+  }
+
+  void TearDown() override {
+    builder.reset();
+    UA_Server_delete(server);
+  }
+
+  RegistrationPipelinePtr makePipeline(size_t workers) {
+    RegistrationConfig config;
+    config.workers = workers;
+    config.queue_capacity = DEVICE_COUNT / 4;
+    return make_unique<RegistrationPipeline>(builder, config);
+  }
+
+  bool hasNode(const string& device_id) {
+    auto node_id = UA_NODEID_STRING_ALLOC(SERVER_NAMESPACE, device_id.c_str());
+    UA_NodeClass node_class;
+    auto status = UA_Server_readNodeClass(server, node_id, &node_class);
+    UA_NodeId_clear(&node_id);
+    return status == UA_STATUSCODE_GOOD;
+  }
+
+  UA_Server* server = nullptr;
+  CallbackRepoPtr repo;
+  shared_ptr<NodeBuilder> builder;
+};
+} // namespace
+
+TEST_F(RegistrationPipelineTests, registersDevices) {
+  auto pipeline = makePipeline(4);
+  for (size_t i = 0; i < DEVICE_COUNT; ++i) {
+    pipeline->add(makeDevice(makeId(i)));
+  }
+  // the pipeline applies all queued events before it is destroyed
+  pipeline.reset();
+
+  for (size_t i = 0; i < DEVICE_COUNT; ++i) {
+    EXPECT_TRUE(hasNode(makeId(i))) << makeId(i);
+  }
+}
+
+TEST_F(RegistrationPipelineTests, appliesRegistrationBurstsInOrder) {
+  auto pipeline = makePipeline(4);
+  for (size_t i = 0; i < DEVICE_COUNT; ++i) {
+    pipeline->add(makeDevice(makeId(i)));
+    // deregistrations are queued behind registrations, that are still
+    // prepared by other workers
+    if (i % 2 == 0) {
+      pipeline->remove(makeId(i));
+    }
+  }
+  // reconnecting devices are registered again after their deregistration
+  for (size_t i = 0; i < DEVICE_COUNT; i += 4) {
+    pipeline->add(makeDevice(makeId(i)));
+  }
+  pipeline.reset();
+
+  for (size_t i = 0; i < DEVICE_COUNT; ++i) {
+    auto registered = i % 2 != 0 || i % 4 == 0;
+    EXPECT_EQ(hasNode(makeId(i)), registered) << makeId(i);
+  }
+}
+
+TEST_F(RegistrationPipelineTests, ignoresUnknownDeregistrations) {
+  auto pipeline = makePipeline(2);
+  pipeline->remove(makeId(0));
+  pipeline->add(makeDevice(makeId(1)));
+  pipeline->remove(makeId(2));
+  pipeline.reset();
+
+  EXPECT_FALSE(hasNode(makeId(0)));
+  EXPECT_TRUE(hasNode(makeId(1)));
+}
+
+TEST_F(RegistrationPipelineTests, registersDevicesWithoutWorkers) {
+  auto pipeline = makePipeline(0);
+  pipeline->add(makeDevice(makeId(0)));
+  pipeline->add(makeDevice(makeId(1)));
+  pipeline->remove(makeId(0));
+
+  EXPECT_FALSE(hasNode(makeId(0)));
+  EXPECT_TRUE(hasNode(makeId(1)));
+}
@@ -0,0 +1,51 @@
+#include "StringConverter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using namespace open62541;
+
+namespace {
+// NOLINTBEGIN(readability-magic-numbers)
+UA_DateTime makeDateTime(UA_UInt16 milli_sec, UA_UInt16 micro_sec) {
+  UA_DateTimeStruct date_time{};
+  date_time.year = 2024;
+  date_time.month = 2;
+  date_time.day = 29;
+  date_time.hour = 13;
+  date_time.min = 5;
+  date_time.sec = 9;
+  date_time.milliSec = milli_sec;
+  date_time.microSec = micro_sec;
+  return UA_DateTime_fromStruct(date_time);
+}
+// NOLINTEND(readability-magic-numbers)
+} // namespace
+
+TEST(StringConverterTests, formatsDateTimes) {
+  EXPECT_EQ(toString(makeDateTime(123, 456)), "2024-02-29 13:05:09.123456");
+}
+
+TEST(StringConverterTests, padsDateTimeFractions) {
+  EXPECT_EQ(toString(makeDateTime(0, 7)), "2024-02-29 13:05:09.000007");
+  EXPECT_EQ(toString(makeDateTime(12, 0)), "2024-02-29 13:05:09.012000");
+}
+
+TEST(StringConverterTests, formatsUnixEpoch) {
+  EXPECT_EQ(toString(UA_DATETIME_UNIX_EPOCH), "1970-01-01 00:00:00.000000");
+}
+
+TEST(StringConverterTests, convertsUaStrings) {
+  auto value = UA_STRING_STATIC("Hello");
+  EXPECT_EQ(toString(&value), "Hello");
+}
+
+TEST(StringConverterTests, convertsSqlTypes) {
+  EXPECT_EQ(toSqlType(&UA_TYPES[UA_TYPES_INT32]), "INT");
+  EXPECT_EQ(toSqlType(&UA_TYPES[UA_TYPES_DATETIME]), "TIMESTAMP(6)");
+  EXPECT_THROW(toSqlType(&UA_TYPES[UA_TYPES_GUID]), logic_error);
+  EXPECT_THROW(toSqlType(nullptr), logic_error);
+}
@@ -0,0 +1,65 @@
+#include "TypeRegistry.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace std;
+using namespace open62541;
+
+namespace {
+template <typename Type> struct SizeOf {
+  static size_t apply() { return sizeof(typename Type::type); }
+};
+
+constexpr auto ALL_SIZES = makeDispatchTable<size_t(), SizeOf>(ScalarTypes{});
+constexpr auto NUMERIC_SIZES =
+    makeDispatchTable<size_t(), SizeOf, true>(ScalarTypes{});
+} // namespace
+
+TEST(TypeRegistryTests, dispatchesEveryScalarType) {
+  EXPECT_EQ(dispatch(ALL_SIZES, UA_DATATYPEKIND_BOOLEAN)(), sizeof(UA_Boolean));
+  EXPECT_EQ(dispatch(ALL_SIZES, UA_DATATYPEKIND_INT16)(), sizeof(UA_Int16));
+  EXPECT_EQ(dispatch(ALL_SIZES, UA_DATATYPEKIND_UINT64)(), sizeof(UA_UInt64));
+  EXPECT_EQ(dispatch(ALL_SIZES, UA_DATATYPEKIND_DOUBLE)(), sizeof(UA_Double));
+  EXPECT_EQ(dispatch(ALL_SIZES, &UA_TYPES[UA_TYPES_STRING])(),
+      sizeof(UA_String));
+}
+
+TEST(TypeRegistryTests, skipsNonNumericTypes) {
+  EXPECT_EQ(dispatch(NUMERIC_SIZES, UA_DATATYPEKIND_BOOLEAN), nullptr);
+  EXPECT_EQ(dispatch(NUMERIC_SIZES, UA_DATATYPEKIND_STRING), nullptr);
+  EXPECT_EQ(dispatch(NUMERIC_SIZES, UA_DATATYPEKIND_DATETIME), nullptr);
+  EXPECT_NE(dispatch(NUMERIC_SIZES, UA_DATATYPEKIND_SBYTE), nullptr);
+  EXPECT_NE(dispatch(NUMERIC_SIZES, UA_DATATYPEKIND_FLOAT), nullptr);
+}
+
+TEST(TypeRegistryTests, returnsNullptrForUnknownTypes) {
+  EXPECT_EQ(dispatch(ALL_SIZES, UA_DATATYPEKIND_GUID), nullptr);
+  EXPECT_EQ(dispatch(ALL_SIZES, TYPE_KINDS), nullptr);
+  EXPECT_EQ(dispatch(ALL_SIZES, &UA_TYPES[UA_TYPES_NODEID]), nullptr);
+  EXPECT_EQ(dispatch(ALL_SIZES, static_cast<const UA_DataType*>(nullptr)),
+      nullptr);
+}
+
+TEST(TypeRegistryTests, describesRegisteredTypes) {
+  auto info = typeInfo(&UA_TYPES[UA_TYPES_INT32]);
+  EXPECT_TRUE(info.registered);
+  EXPECT_TRUE(info.numeric);
+  EXPECT_EQ(string(info.sql_type), "INT");
+
+  info = typeInfo(&UA_TYPES[UA_TYPES_DATETIME]);
+  EXPECT_TRUE(info.registered);
+  EXPECT_FALSE(info.numeric);
+  EXPECT_EQ(string(info.sql_type), "TIMESTAMP(6)");
+}
+
+TEST(TypeRegistryTests, doesNotDescribeUnregisteredTypes) {
+  auto info = typeInfo(&UA_TYPES[UA_TYPES_GUID]);
+  EXPECT_FALSE(info.registered);
+  EXPECT_EQ(info.sql_type, nullptr);
+
+  info = typeInfo(nullptr);
+  EXPECT_FALSE(info.registered);
+  EXPECT_EQ(info.sql_type, nullptr);
+}
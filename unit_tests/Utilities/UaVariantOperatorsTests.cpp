@@ -0,0 +1,157 @@
+#include "UaVariantOperators.hpp"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+using namespace open62541;
+
+namespace {
+template <typename T>
+UA_Variant makeVariant(T value, const UA_DataType* type) {
+  UA_Variant result;
+  UA_Variant_init(&result);
+  UA_Variant_setScalarCopy(&result, &value, type);
+  return result;
+}
+
+/**
+ * @brief Reads the scalar of the given result and clears it
+ *
+ */
+template <typename T> T takeValue(UA_Variant result, const UA_DataType* type) {
+  EXPECT_EQ(result.type, type);
+  auto value = *static_cast<T*>(result.data);
+  UA_Variant_clear(&result);
+  return value;
+}
+
+struct UaVariantOperatorsTests : public testing::Test {
+  void TearDown() override {
+    UA_Variant_clear(&lhs);
+    UA_Variant_clear(&rhs);
+  }
+
+  UA_Variant lhs{};
+  UA_Variant rhs{};
+};
+
+const UA_DataType* INT16 = &UA_TYPES[UA_TYPES_INT16];
+const UA_DataType* INT32 = &UA_TYPES[UA_TYPES_INT32];
+const UA_DataType* INT64 = &UA_TYPES[UA_TYPES_INT64];
+const UA_DataType* BYTE = &UA_TYPES[UA_TYPES_BYTE];
+const UA_DataType* UINT32 = &UA_TYPES[UA_TYPES_UINT32];
+const UA_DataType* DOUBLE = &UA_TYPES[UA_TYPES_DOUBLE];
+} // namespace
+
+TEST_F(UaVariantOperatorsTests, multipliesIntegers) {
+  lhs = makeVariant<UA_Int32>(7, INT32);
+  EXPECT_EQ(takeValue<UA_Int32>(lhs * 3, INT32), 21);
+  EXPECT_EQ(takeValue<UA_Int32>(lhs * -3, INT32), -21);
+}
+
+TEST_F(UaVariantOperatorsTests, clampsMultiplicationOverflow) {
+  lhs = makeVariant<UA_Int16>(30000, INT16);
+  EXPECT_EQ(
+      takeValue<UA_Int16>(lhs * 2, INT16), numeric_limits<UA_Int16>::max());
+  EXPECT_EQ(
+      takeValue<UA_Int16>(lhs * -2, INT16), numeric_limits<UA_Int16>::min());
+}
+
+TEST_F(UaVariantOperatorsTests, dividesValues) {
+  lhs = makeVariant<UA_Int32>(7, INT32);
+  EXPECT_EQ(takeValue<UA_Int32>(lhs / 2, INT32), 3);
+  rhs = makeVariant<UA_Double>(7.0, DOUBLE);
+  EXPECT_DOUBLE_EQ(takeValue<UA_Double>(rhs / 2, DOUBLE), 3.5);
+}
+
+TEST_F(UaVariantOperatorsTests, throwsOnDivisionByZero) {
+  lhs = makeVariant<UA_Int32>(7, INT32);
+  EXPECT_THROW(lhs / 0, logic_error);
+  rhs = makeVariant<UA_Double>(7.0, DOUBLE);
+  EXPECT_THROW(rhs / 0, logic_error);
+}
+
+TEST_F(UaVariantOperatorsTests, addsValues) {
+  lhs = makeVariant<UA_Int32>(-5, INT32);
+  rhs = makeVariant<UA_Int32>(12, INT32);
+  EXPECT_EQ(takeValue<UA_Int32>(lhs + rhs, INT32), 7);
+}
+
+TEST_F(UaVariantOperatorsTests, clampsSignedSumOverflow) {
+  lhs = makeVariant<UA_Int64>(numeric_limits<UA_Int64>::max() - 1, INT64);
+  rhs = makeVariant<UA_Int64>(2, INT64);
+  EXPECT_EQ(
+      takeValue<UA_Int64>(lhs + rhs, INT64), numeric_limits<UA_Int64>::max());
+  UA_Variant_clear(&lhs);
+  UA_Variant_clear(&rhs);
+  lhs = makeVariant<UA_Int64>(numeric_limits<UA_Int64>::min() + 1, INT64);
+  rhs = makeVariant<UA_Int64>(-2, INT64);
+  EXPECT_EQ(
+      takeValue<UA_Int64>(lhs + rhs, INT64), numeric_limits<UA_Int64>::min());
+}
+
+TEST_F(UaVariantOperatorsTests, clampsUnsignedSumOverflow) {
+  lhs = makeVariant<UA_Byte>(200, BYTE);
+  rhs = makeVariant<UA_Byte>(100, BYTE);
+  EXPECT_EQ(
+      takeValue<UA_Byte>(lhs + rhs, BYTE), numeric_limits<UA_Byte>::max());
+  UA_Variant_clear(&lhs);
+  UA_Variant_clear(&rhs);
+  lhs = makeVariant<UA_UInt32>(4000000000, UINT32);
+  rhs = makeVariant<UA_UInt32>(1000000000, UINT32);
+  EXPECT_EQ(takeValue<UA_UInt32>(lhs + rhs, UINT32),
+      numeric_limits<UA_UInt32>::max());
+}
+
+TEST_F(UaVariantOperatorsTests, subtractsValues) {
+  lhs = makeVariant<UA_Int32>(5, INT32);
+  rhs = makeVariant<UA_Int32>(-12, INT32);
+  EXPECT_EQ(takeValue<UA_Int32>(lhs - rhs, INT32), 17);
+  EXPECT_EQ(takeValue<UA_Int32>(rhs - lhs, INT32), -17);
+}
+
+TEST_F(UaVariantOperatorsTests, clampsSignedDifferenceOverflow) {
+  lhs = makeVariant<UA_Int16>(30000, INT16);
+  rhs = makeVariant<UA_Int16>(-30000, INT16);
+  EXPECT_EQ(
+      takeValue<UA_Int16>(lhs - rhs, INT16), numeric_limits<UA_Int16>::max());
+  EXPECT_EQ(
+      takeValue<UA_Int16>(rhs - lhs, INT16), numeric_limits<UA_Int16>::min());
+}
+
+TEST_F(UaVariantOperatorsTests, clampsUnsignedDifferenceUnderflow) {
+  lhs = makeVariant<UA_UInt32>(10, UINT32);
+  rhs = makeVariant<UA_UInt32>(20, UINT32);
+  EXPECT_EQ(takeValue<UA_UInt32>(lhs - rhs, UINT32), 0);
+  EXPECT_EQ(takeValue<UA_UInt32>(rhs - lhs, UINT32), 10);
+}
+
+TEST_F(UaVariantOperatorsTests, rejectsBooleanValues) {
+  UA_Boolean value = true;
+  lhs = makeVariant(value, &UA_TYPES[UA_TYPES_BOOLEAN]);
+  rhs = makeVariant(value, &UA_TYPES[UA_TYPES_BOOLEAN]);
+  EXPECT_THROW(lhs * 2, logic_error);
+  EXPECT_THROW(lhs / 2, logic_error);
+  EXPECT_THROW(lhs + rhs, logic_error);
+  EXPECT_THROW(lhs - rhs, logic_error);
+}
+
+TEST_F(UaVariantOperatorsTests, rejectsNonNumericValues) {
+  auto value = UA_STRING_STATIC("text");
+  lhs = makeVariant(value, &UA_TYPES[UA_TYPES_STRING]);
+  rhs = makeVariant(value, &UA_TYPES[UA_TYPES_STRING]);
+  EXPECT_THROW(lhs * 2, logic_error);
+  EXPECT_THROW(lhs / 2, logic_error);
+  EXPECT_THROW(lhs + rhs, logic_error);
+  EXPECT_THROW(lhs - rhs, logic_error);
+}
+
+TEST_F(UaVariantOperatorsTests, rejectsNonMatchingTypes) {
+  lhs = makeVariant<UA_Int32>(1, INT32);
+  rhs = makeVariant<UA_Int64>(1, INT64);
+  EXPECT_THROW(lhs + rhs, logic_error);
+  EXPECT_THROW(lhs - rhs, logic_error);
+}
@@ -0,0 +1,184 @@
+#include "VariantConverter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace open62541;
+using namespace Information_Model;
+
+namespace {
+/**
+ * @brief Converts the given value into a UA_Variant and back
+ *
+ */
+DataVariant roundTrip(const DataVariant& value, const UA_DataType* type) {
+  UA_Variant variant;
+  toUAVariant(value, &variant);
+  EXPECT_EQ(variant.type, type);
+  EXPECT_TRUE(UA_Variant_isScalar(&variant));
+  auto result = toDataVariant(variant);
+  UA_Variant_clear(&variant);
+  return result;
+}
+
+UA_NumericRange makeRange(UA_UInt32 min, UA_UInt32 max) {
+  static UA_NumericRangeDimension dimension;
+  dimension.min = min;
+  dimension.max = max;
+  UA_NumericRange result;
+  result.dimensionsSize = 1;
+  result.dimensions = &dimension;
+  return result;
+}
+
+string toStdString(const UA_Variant& variant) {
+  const auto* value = static_cast<const UA_String*>(variant.data);
+  return string(reinterpret_cast<const char*>(value->data), value->length);
+}
+} // namespace
+
+TEST(VariantConverterTests, convertsBooleans) {
+  auto result = roundTrip(true, &UA_TYPES[UA_TYPES_BOOLEAN]);
+  EXPECT_TRUE(get<bool>(result));
+  result = roundTrip(false, &UA_TYPES[UA_TYPES_BOOLEAN]);
+  EXPECT_FALSE(get<bool>(result));
+}
+
+TEST(VariantConverterTests, convertsIntegers) {
+  auto value = numeric_limits<intmax_t>::min();
+  auto result = roundTrip(value, &UA_TYPES[UA_TYPES_INT64]);
+  EXPECT_EQ(get<intmax_t>(result), value);
+}
+
+TEST(VariantConverterTests, convertsUnsignedIntegers) {
+  auto value = numeric_limits<uintmax_t>::max();
+  auto result = roundTrip(value, &UA_TYPES[UA_TYPES_UINT64]);
+  EXPECT_EQ(get<uintmax_t>(result), value);
+}
+
+TEST(VariantConverterTests, convertsDoubles) {
+  auto result = roundTrip(-12.625, &UA_TYPES[UA_TYPES_DOUBLE]);
+  EXPECT_DOUBLE_EQ(get<double>(result), -12.625);
+}
+
+TEST(VariantConverterTests, convertsTimestamps) {
+  // NOLINTNEXTLINE(readability-magic-numbers)
+  Timestamp value{2024, 2, 29, 13, 5, 9, 123456};
+  auto result = roundTrip(value, &UA_TYPES[UA_TYPES_DATETIME]);
+  auto timestamp = get<Timestamp>(result);
+  EXPECT_EQ(timestamp.year, value.year);
+  EXPECT_EQ(timestamp.month, value.month);
+  EXPECT_EQ(timestamp.day, value.day);
+  EXPECT_EQ(timestamp.hours, value.hours);
+  EXPECT_EQ(timestamp.minutes, value.minutes);
+  EXPECT_EQ(timestamp.seconds, value.seconds);
+  EXPECT_EQ(timestamp.microseconds, value.microseconds);
+}
+
+TEST(VariantConverterTests, convertsStrings) {
+  auto result = roundTrip(string("Hello"), &UA_TYPES[UA_TYPES_STRING]);
+  EXPECT_EQ(get<string>(result), "Hello");
+  result = roundTrip(string(), &UA_TYPES[UA_TYPES_STRING]);
+  EXPECT_EQ(get<string>(result), "");
+}
+
+TEST(VariantConverterTests, convertsByteStrings) {
+  vector<uint8_t> value{0x00, 0x7F, 0xFF};
+  auto result = roundTrip(value, &UA_TYPES[UA_TYPES_BYTESTRING]);
+  EXPECT_EQ(get<vector<uint8_t>>(result), value);
+  result = roundTrip(vector<uint8_t>(), &UA_TYPES[UA_TYPES_BYTESTRING]);
+  EXPECT_TRUE(get<vector<uint8_t>>(result).empty());
+}
+
+TEST(VariantConverterTests, widensNarrowTypes) {
+  UA_Variant variant;
+  UA_Int16 signed_value = -7;
+  UA_Variant_setScalar(&variant, &signed_value, &UA_TYPES[UA_TYPES_INT16]);
+  EXPECT_EQ(get<intmax_t>(toDataVariant(variant)), -7);
+
+  UA_Byte unsigned_value = 200;
+  UA_Variant_setScalar(&variant, &unsigned_value, &UA_TYPES[UA_TYPES_BYTE]);
+  EXPECT_EQ(get<uintmax_t>(toDataVariant(variant)), 200);
+
+  UA_Float float_value = 0.5F;
+  UA_Variant_setScalar(&variant, &float_value, &UA_TYPES[UA_TYPES_FLOAT]);
+  EXPECT_DOUBLE_EQ(get<double>(toDataVariant(variant)), 0.5);
+}
+
+TEST(VariantConverterTests, rejectsArrays) {
+  UA_Variant variant;
+  UA_Int32 values[] = {1, 2};
+  UA_Variant_setArray(&variant, values, 2, &UA_TYPES[UA_TYPES_INT32]);
+  EXPECT_THROW(toDataVariant(variant), runtime_error);
+}
+
+TEST(VariantConverterTests, rejectsEmptyVariants) {
+  UA_Variant variant;
+  UA_Variant_init(&variant);
+  EXPECT_THROW(toDataVariant(variant), runtime_error);
+}
+
+TEST(VariantConverterTests, rejectsUnsupportedTypes) {
+  UA_Variant variant;
+  UA_Guid value = UA_GUID_NULL;
+  UA_Variant_setScalar(&variant, &value, &UA_TYPES[UA_TYPES_GUID]);
+  EXPECT_THROW(toDataVariant(variant), runtime_error);
+}
+
+TEST(VariantConverterTests, convertsStringRanges) {
+  UA_Variant variant;
+  ASSERT_EQ(toUAVariant(string("Hello"), makeRange(1, 3), &variant),
+      UA_STATUSCODE_GOOD);
+  EXPECT_EQ(variant.type, &UA_TYPES[UA_TYPES_STRING]);
+  EXPECT_EQ(toStdString(variant), "ell");
+  UA_Variant_clear(&variant);
+}
+
+TEST(VariantConverterTests, convertsByteStringRanges) {
+  UA_Variant variant;
+  vector<uint8_t> value{1, 2, 3, 4};
+  ASSERT_EQ(
+      toUAVariant(value, makeRange(2, 2), &variant), UA_STATUSCODE_GOOD);
+  EXPECT_EQ(variant.type, &UA_TYPES[UA_TYPES_BYTESTRING]);
+  const auto* bytes = static_cast<const UA_ByteString*>(variant.data);
+  ASSERT_EQ(bytes->length, 1);
+  EXPECT_EQ(bytes->data[0], 3);
+  UA_Variant_clear(&variant);
+}
+
+TEST(VariantConverterTests, cutsRangesAtTheLastByte) {
+  UA_Variant variant;
+  ASSERT_EQ(toUAVariant(string("Hello"), makeRange(3, 100), &variant),
+      UA_STATUSCODE_GOOD);
+  EXPECT_EQ(toStdString(variant), "lo");
+  UA_Variant_clear(&variant);
+}
+
+TEST(VariantConverterTests, rejectsRangesWithoutData) {
+  UA_Variant variant;
+  EXPECT_EQ(toUAVariant(string("Hello"), makeRange(5, 7), &variant),
+      UA_STATUSCODE_BADINDEXRANGENODATA);
+  EXPECT_TRUE(UA_Variant_isEmpty(&variant));
+  EXPECT_EQ(toUAVariant(string(), makeRange(0, 0), &variant),
+      UA_STATUSCODE_BADINDEXRANGENODATA);
+  EXPECT_EQ(toUAVariant(DataVariant(intmax_t{5}), makeRange(0, 0), &variant),
+      UA_STATUSCODE_BADINDEXRANGENODATA);
+
+  UA_NumericRangeDimension dimensions[] = {{0, 1}, {0, 1}};
+  UA_NumericRange range{2, dimensions};
+  EXPECT_EQ(toUAVariant(string("Hello"), range, &variant),
+      UA_STATUSCODE_BADINDEXRANGENODATA);
+}
+
+TEST(VariantConverterTests, rejectsReversedRanges) {
+  UA_Variant variant;
+  EXPECT_EQ(toUAVariant(string("Hello"), makeRange(3, 1), &variant),
+      UA_STATUSCODE_BADINDEXRANGEINVALID);
+  EXPECT_TRUE(UA_Variant_isEmpty(&variant));
+}